@@ -0,0 +1,233 @@
+#include "batch.hpp"
+#include "extended.hpp"
+
+//math on the parts is unqualified so the double-double and quad-double versions are found too
+using std::sqrt;
+using std::atan2;
+using std::abs;
+using std::sin;
+using std::cos;
+using std::sinh;
+using std::cosh;
+using std::log;
+using std::exp;
+
+//Every function here is a plain loop over the lanes with no branches so the compiler can turn
+//it into AVX2/AVX-512 instructions (sin, cos, log etc. go to the vector math library when
+//compiled with fast math). Without those the same loops are just the scalar code.
+
+template<typename T>
+void broadcast(basicDualBatch<T>& out, double re, double im, double derivativeRe, double derivativeIm) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        out.value.re[i] = re;
+        out.value.im[i] = im;
+        out.derivative.re[i] = derivativeRe;
+        out.derivative.im[i] = derivativeIm;
+    }
+}
+
+template<typename T>
+void add(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        out.value.re[i] = a.value.re[i] + b.value.re[i];
+        out.value.im[i] = a.value.im[i] + b.value.im[i];
+        out.derivative.re[i] = a.derivative.re[i] + b.derivative.re[i];
+        out.derivative.im[i] = a.derivative.im[i] + b.derivative.im[i];
+    }
+}
+
+template<typename T>
+void subtract(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        out.value.re[i] = a.value.re[i] - b.value.re[i];
+        out.value.im[i] = a.value.im[i] - b.value.im[i];
+        out.derivative.re[i] = a.derivative.re[i] - b.derivative.re[i];
+        out.derivative.im[i] = a.derivative.im[i] - b.derivative.im[i];
+    }
+}
+
+template<typename T>
+void multiply(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T are = a.value.re[i], aim = a.value.im[i];
+        T bre = b.value.re[i], bim = b.value.im[i];
+        T adre = a.derivative.re[i], adim = a.derivative.im[i];
+        T bdre = b.derivative.re[i], bdim = b.derivative.im[i];
+        out.value.re[i] = (are * bre) - (aim * bim);
+        out.value.im[i] = (aim * bre) + (are * bim);
+        out.derivative.re[i] = ((adre * bre) - (adim * bim)) + ((are * bdre) - (aim * bdim));
+        out.derivative.im[i] = ((adim * bre) + (adre * bim)) + ((aim * bdre) + (are * bdim));
+    }
+}
+
+//(a/b)' = (a' - (a/b)*b')/b
+template<typename T>
+void divide(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T are = a.value.re[i], aim = a.value.im[i];
+        T bre = b.value.re[i], bim = b.value.im[i];
+        T c = 1 / ((bre * bre) + (bim * bim));
+        T vre = ((are * bre) + (aim * bim)) * c;
+        T vim = ((-are * bim) + (aim * bre)) * c;
+        T tre = a.derivative.re[i] - ((vre * b.derivative.re[i]) - (vim * b.derivative.im[i]));
+        T tim = a.derivative.im[i] - ((vim * b.derivative.re[i]) + (vre * b.derivative.im[i]));
+        out.value.re[i] = vre;
+        out.value.im[i] = vim;
+        out.derivative.re[i] = ((tre * bre) + (tim * bim)) * c;
+        out.derivative.im[i] = ((-tre * bim) + (tim * bre)) * c;
+    }
+}
+
+//(1/a)' = -(1/a)*(a'/a)
+template<typename T>
+void reciprocal(basicDualBatch<T>& out, const basicDualBatch<T>& a) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T are = a.value.re[i], aim = a.value.im[i];
+        T c = 1 / ((are * are) + (aim * aim));
+        T vre = are * c;
+        T vim = -aim * c;
+        T qre = ((a.derivative.re[i] * are) + (a.derivative.im[i] * aim)) * c;
+        T qim = ((-a.derivative.re[i] * aim) + (a.derivative.im[i] * are)) * c;
+        out.value.re[i] = vre;
+        out.value.im[i] = vim;
+        out.derivative.re[i] = -((vre * qre) - (vim * qim));
+        out.derivative.im[i] = -((vim * qre) + (vre * qim));
+    }
+}
+
+template<typename T>
+void square(basicDualBatch<T>& out, const basicDualBatch<T>& a) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T are = a.value.re[i], aim = a.value.im[i];
+        T dre = a.derivative.re[i], dim = a.derivative.im[i];
+        out.value.re[i] = (are * are) - (aim * aim);
+        out.value.im[i] = (aim * are) + (are * aim);
+        out.derivative.re[i] = 2 * ((dre * are) - (dim * aim));
+        out.derivative.im[i] = 2 * ((dim * are) + (dre * aim));
+    }
+}
+
+template<typename T>
+void sincos(basicDualBatch<T>& s, basicDualBatch<T>& c, const basicDualBatch<T>& x) {
+    //sin and cos go in separate loops, otherwise the compiler merges them into a sincos call that it can't vectorize
+    T sinre[batchSize<T>], cosre[batchSize<T>];
+    for (int i = 0; i < batchSize<T>; i++)
+        sinre[i] = sin(x.value.re[i]);
+    for (int i = 0; i < batchSize<T>; i++)
+        cosre[i] = cos(x.value.re[i]);
+    for (int i = 0; i < batchSize<T>; i++) {
+        T coshim = cosh(x.value.im[i]);
+        T sinhim = sinh(x.value.im[i]);
+        T sre = sinre[i] * coshim, sim = cosre[i] * sinhim;
+        T cre = cosre[i] * coshim, cim = -sinre[i] * sinhim;
+        T dre = x.derivative.re[i], dim = x.derivative.im[i];
+        s.value.re[i] = sre;
+        s.value.im[i] = sim;
+        c.value.re[i] = cre;
+        c.value.im[i] = cim;
+        s.derivative.re[i] = (cre * dre) - (cim * dim);
+        s.derivative.im[i] = (cim * dre) + (cre * dim);
+        c.derivative.re[i] = -((sre * dre) - (sim * dim));
+        c.derivative.im[i] = -((sim * dre) + (sre * dim));
+    }
+}
+
+template<typename T>
+void log(basicDualBatch<T>& out, const basicDualBatch<T>& x) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T re = x.value.re[i], im = x.value.im[i];
+        T c = 1 / ((re * re) + (im * im));
+        out.value.re[i] = log(sqrt((re * re) + (im * im)));
+        out.value.im[i] = atan2(im, re);
+        out.derivative.re[i] = ((x.derivative.re[i] * re) + (x.derivative.im[i] * im)) * c;
+        out.derivative.im[i] = ((-x.derivative.re[i] * im) + (x.derivative.im[i] * re)) * c;
+    }
+}
+
+/// @brief out = a * b for the values of every lane
+template<typename T>
+static void multiply(basicComplexBatch<T>& out, const basicComplexBatch<T>& a, const basicComplexBatch<T>& b) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T re = (a.re[i] * b.re[i]) - (a.im[i] * b.im[i]);
+        T im = (a.im[i] * b.re[i]) + (a.re[i] * b.im[i]);
+        out.re[i] = re;
+        out.im[i] = im;
+    }
+}
+
+//(x^n)' = n*x^(n-1)*x', x^(n-1) comes from repeated squaring
+template<typename T>
+void powi(basicDualBatch<T>& out, const basicDualBatch<T>& x, int n) {
+    basicComplexBatch<T> previous, base = x.value;
+    for (int i = 0; i < batchSize<T>; i++) {
+        previous.re[i] = 1;
+        previous.im[i] = 0;
+    }
+    int m = n - 1;
+    while (m > 0) {
+        if (m & 1) multiply(previous, previous, base);
+        m >>= 1;
+        if (m > 0) multiply(base, base, base);
+    }
+    multiply(out.value, previous, x.value);
+    multiply(out.derivative, previous, x.derivative);
+    for (int i = 0; i < batchSize<T>; i++) {
+        out.derivative.re[i] *= n;
+        out.derivative.im[i] *= n;
+    }
+}
+
+//a^b = exp(b*ln(a)), (a^b)' = a^b*(b'*ln(a) + b*a'/a)
+template<typename T>
+void pow(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b) {
+    T lre[batchSize<T>], lim[batchSize<T>], eim[batchSize<T>], cosim[batchSize<T>], sinim[batchSize<T>];
+    for (int i = 0; i < batchSize<T>; i++) {
+        T are = a.value.re[i], aim = a.value.im[i];
+        T bre = b.value.re[i], bim = b.value.im[i];
+        lre[i] = log(sqrt((are * are) + (aim * aim)));
+        lim[i] = atan2(aim, are);
+        eim[i] = (bim * lre[i]) + (bre * lim[i]);
+    }
+    //separate loops for the same reason as sincos
+    for (int i = 0; i < batchSize<T>; i++)
+        cosim[i] = cos(eim[i]);
+    for (int i = 0; i < batchSize<T>; i++)
+        sinim[i] = sin(eim[i]);
+    for (int i = 0; i < batchSize<T>; i++) {
+        T are = a.value.re[i], aim = a.value.im[i];
+        T bre = b.value.re[i], bim = b.value.im[i];
+        T c = 1 / ((are * are) + (aim * aim));
+        T ere = (bre * lre[i]) - (bim * lim[i]);
+        T e = exp(ere);
+        T vre = e * cosim[i];
+        T vim = e * sinim[i];
+        //a'/a
+        T qre = ((a.derivative.re[i] * are) + (a.derivative.im[i] * aim)) * c;
+        T qim = ((-a.derivative.re[i] * aim) + (a.derivative.im[i] * are)) * c;
+        T tre = ((b.derivative.re[i] * lre[i]) - (b.derivative.im[i] * lim[i])) + ((bre * qre) - (bim * qim));
+        T tim = ((b.derivative.im[i] * lre[i]) + (b.derivative.re[i] * lim[i])) + ((bim * qre) + (bre * qim));
+        out.value.re[i] = vre;
+        out.value.im[i] = vim;
+        out.derivative.re[i] = (vre * tre) - (vim * tim);
+        out.derivative.im[i] = (vim * tre) + (vre * tim);
+    }
+}
+
+//float batches have twice the lanes of double batches for the same register width, double-double half and quad-double a quarter
+#define INSTANTIATE_BATCH(T) \
+    template void broadcast(basicDualBatch<T>&, double, double, double, double); \
+    template void add(basicDualBatch<T>&, const basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void subtract(basicDualBatch<T>&, const basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void multiply(basicDualBatch<T>&, const basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void divide(basicDualBatch<T>&, const basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void reciprocal(basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void square(basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void sincos(basicDualBatch<T>&, basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void log(basicDualBatch<T>&, const basicDualBatch<T>&); \
+    template void powi(basicDualBatch<T>&, const basicDualBatch<T>&, int); \
+    template void pow(basicDualBatch<T>&, const basicDualBatch<T>&, const basicDualBatch<T>&);
+
+INSTANTIATE_BATCH(float)
+INSTANTIATE_BATCH(double)
+INSTANTIATE_BATCH(doubleDouble)
+INSTANTIATE_BATCH(quadDouble)
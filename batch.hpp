@@ -0,0 +1,72 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/// @brief number of points of type T evaluated together, enough to fill one AVX-512 register or two AVX2 registers
+template<typename T>
+constexpr int batchSize = 64 / sizeof(T);
+
+/// @brief number of points in a double batch
+constexpr int BATCH_SIZE = batchSize<double>;
+
+/// @brief complex numbers stored as a structure of arrays so every loop over the lanes can be vectorized
+template<typename T>
+struct basicComplexBatch {
+    alignas(64) T re[batchSize<T>];
+    alignas(64) T im[batchSize<T>];
+};
+
+/// @brief batch version of dual, a value and its derivative for each lane
+template<typename T>
+struct basicDualBatch {
+    basicComplexBatch<T> value, derivative;
+};
+
+/// @return weather v is neither NAN nor infinite. Checked on the bits because fast math assumes
+/// neither can happen, but unlike isnanIEEE754 this is inline so it can be vectorized across lanes
+template<typename T>
+inline bool isfiniteLane(T v) {
+    typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type bits;
+    constexpr bits exponent = sizeof(T) == 4 ? bits(0x7F800000) : bits(0x7FF0000000000000);
+    bits i;
+    std::memcpy(&i, &v, sizeof(T));
+    return (i & exponent) != exponent;
+}
+
+typedef basicComplexBatch<double> complexBatch;
+typedef basicDualBatch<double> dualBatch;
+
+template<typename T>
+void broadcast(basicDualBatch<T>& out, double re, double im, double derivativeRe, double derivativeIm);
+
+template<typename T>
+void add(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b);
+
+template<typename T>
+void subtract(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b);
+
+template<typename T>
+void multiply(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b);
+
+template<typename T>
+void divide(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b);
+
+template<typename T>
+void reciprocal(basicDualBatch<T>& out, const basicDualBatch<T>& a);
+
+template<typename T>
+void square(basicDualBatch<T>& out, const basicDualBatch<T>& a);
+
+template<typename T>
+void sincos(basicDualBatch<T>& s, basicDualBatch<T>& c, const basicDualBatch<T>& x);
+
+template<typename T>
+void log(basicDualBatch<T>& out, const basicDualBatch<T>& x);
+
+template<typename T>
+void powi(basicDualBatch<T>& out, const basicDualBatch<T>& x, int n);
+
+template<typename T>
+void pow(basicDualBatch<T>& out, const basicDualBatch<T>& a, const basicDualBatch<T>& b);
@@ -2,10 +2,15 @@
 
 #ifdef __DEBUG
 #define assert(expr) if(!expr) std::cout << "Assert error on line " << __LINE__ << " in file " << __FILE__ << std::endl; throw __LINE__
-#else 
+#else
 #define assert(expr)
 #endif
 
+//rows are put together in a buffer of about this many bytes before they are written to the file
+constexpr int WRITE_BUFFER_SIZE = 1 << 20;
+
+static_assert(sizeof(pixel) == 3, "rows of pixels are copied into the file as they are");
+
 //add two pixels together with clamping at 255
 pixel operator +(pixel a,pixel b) {
 	pixel c(0);
@@ -30,72 +35,136 @@ pixel operator +(pixel a,pixel b) {
 	return c;
 }
 
+/// @brief Work out the sizes of the file for an image
+/// @return weather or not the file fits in the 32 bit sizes of the header, about 4GB
+bool bmp::setSize(int _width, int _height) {
+	width = _width;
+	height = _height;
+	if (std::size_t(width) * 3 % 4 == 0) {
+		rowWidthBytes = std::size_t(width) * 3;
+	}
+	else {
+		rowWidthBytes = std::size_t(width) * 3 + (4 - (std::size_t(width) * 3) % 4);
+	}
+	arraysize = uint64_t(rowWidthBytes) * height;
+	filesize = bmpheadersize + dibheadersize + arraysize;
+	return filesize <= UINT32_MAX;
+}
+
+/// @return weather or not an image this size can be saved as a bmp
+bool bmp::fits(int _width, int _height) {
+	return bmp("").setSize(_width, _height);
+}
+
+/// @brief Write both headers
+/// @param out where to write them, bmpheadersize + dibheadersize bytes
+void bmp::writeHeader(char* out) {
+	//BMP Header
+	write(out, short(0x4d42));			//ID field "BM"
+	write(out, uint32_t(filesize));		//File size
+	write(out, 0);						//Unused
+	write(out, int(54));				//Offset where the pixel array (bitmap data) can be found
+
+	//DIB Header
+	write(out, 40);						//Number of bytes in the DIB header (from this point)
+	write(out, width);					//Width of the bitmap in pixels
+	write(out, height);					//Height of the bitmap in pixels
+	write(out, short(1));				//Number of color panes
+	write(out, short(24));				//Bits per pixel
+	write(out, 0);						//Compression
+	write(out, uint32_t(arraysize));	//Pixel array size
+	write(out, 2835);					//Horizontal print resolution
+	write(out, 2835);					//Vertical print resolution
+	write(out, 0);						//colors in palette
+	write(out, 0);						//important colors
+}
+
 /// @brief Write image data to the file
 /// @param imgdata struct containing rgb values for each pixel
 /// @return weather or not the file was saved sucessfully
-bool bmp::writeFile(imgdata imgdata) {
+bool bmp::writeFile(const imgdata& imgdata) {
+	return writeFile(imgdata.data.view());
+}
+
+/// @brief Write image data to the file
+/// @param image rgb values for each pixel, top row first
+/// @return weather or not the file was saved sucessfully
+bool bmp::writeFile(framebufferView<const pixel> image) {
+	bool written = begin(image.width, image.height) && writeRows(image);
+	return finish() && written;
+}
+
+/// @brief Open the file and write the headers for an image, the rows are then added with writeRows
+/// @return weather or not the file could be opened
+bool bmp::begin(int _width, int _height) {
+	//a header with sizes that wrapped around would make a broken file
+	if (!setSize(_width, _height)) return false;
+	file.open("./images/" + filename, std::fstream::binary);
+	if (!file) return false;
+	std::vector<char> header(bmpheadersize + dibheadersize);
+	writeHeader(header.data());
+	file.write(header.data(), header.size());
+	return !file.fail();
+}
+
+/// @brief Add rows to the file, a batch of rows at a time. A bmp starts with the bottom row, so the rows of an image
+/// are added from the bottom band up
+/// @param rows rgb values for each pixel of the next rows of the image, top row first
+/// @return weather or not the rows were written
+bool bmp::writeRows(framebufferView<const pixel> rows) {
 	try{
-		data = imgdata;
-		width = imgdata.width;
-		height = imgdata.height;
-		if (width * 3 % 4 == 0) {
-			rowWidthBytes = width * 3;
-		}
-		else {
-			rowWidthBytes = width * 3 + (4 - (width * 3) % 4);
-		}
-		arraysize = rowWidthBytes * height;
-		filesize = bmpheadersize + dibheadersize + arraysize;
-		file.open("./images/" + filename, std::fstream::binary);
-		
-		//BMP Header
-		write(short(0x4d42));			//ID field "BM"
-		write(filesize);				//File size
-		write(0);						//Unused
-		write(int(54));					//Offset where the pixel array (bitmap data) can be found
-
-		//DIB Header
-		write(40);						//Number of bytes in the DIB header (from this point)
-		write(width);					//Width of the bitmap in pixels
-		write(height);					//Height of the bitmap in pixels
-		write(short(1));				//Number of color panes
-		write(short(24));				//Bits per pixel		
-		write(0);						//Compression
-		write(arraysize);				//Pixel array size
-		write(2835);					//Horizontal print resolution
-		write(2835);					//Vertical print resolution
-		write(0);						//colors in palette
-		write(0);						//important colors
-		
-		//pixel array
 		assert(rowWidthBytes % 4 == 0);
-		for (int i = height - 1; i >= 0; i--)
+		int rowsPerBatch = int(std::max<std::size_t>(WRITE_BUFFER_SIZE / std::max<std::size_t>(rowWidthBytes, 1), 1));
+		std::vector<char> buffer(std::size_t(std::min(rowsPerBatch, rows.height)) * rowWidthBytes, 0);
+		for (int i = rows.height - 1; i >= 0; i -= rowsPerBatch)
 		{
-			int j = 0;
-			while (j < width) {
-				write(data.data[j][i].b);
-				write(data.data[j][i].g);
-				write(data.data[j][i].r);
-				j++;
-			}
-			j *= 3;
-			while (j < rowWidthBytes) {
-				write((unsigned char)(0));
-				j++;
+			int count = std::min(rowsPerBatch, i + 1);
+			for (int k = 0; k < count; k++) {
+				//the padding at the end of each row stays 0 from when the buffer was made
+				std::memcpy(buffer.data() + std::size_t(k) * rowWidthBytes, rows.row(i - k), std::size_t(width) * 3);
 			}
+			file.write(buffer.data(), std::size_t(count) * rowWidthBytes);
 		}
-		file.close();
-		return true;
+		return !file.fail();
 	}
 	catch(int exc){
 		return false;
 	}
 }
 
+/// @brief Close the file once every row is written
+/// @return weather or not the file was saved sucessfully
+bool bmp::finish() {
+	if (!file.is_open()) return false;
+	file.close();
+	return !file.fail();
+}
+
+/// @brief Make the file at its full size and map it into memory so an image can be rendered straight into it,
+/// then unmap saves it. Only works when the rows of the file have no padding, so when the width is a multiple of 4
+/// @return the pixels in the file top row first, or no data if the file couldn't be mapped
+framebufferView<pixel> bmp::map(int _width, int _height) {
+	if (!setSize(_width, _height) || rowWidthBytes != std::size_t(width) * 3 || arraysize == 0)
+		return { nullptr, 0, 0, 0 };
+	char* mapped = mapping.open("./images/" + filename, filesize);
+	if (mapped == nullptr)
+		return { nullptr, 0, 0, 0 };
+	writeHeader(mapped);
+	//the last row in the file is the top of the image, going up the image goes back through the file
+	pixel* top = (pixel*)(mapped + bmpheadersize + dibheadersize) + std::ptrdiff_t(height - 1) * width;
+	return { top, width, height, -std::ptrdiff_t(width) };
+}
+
+/// @brief Unmap the file from map, which finishes writing it
+/// @return weather or not the file was saved sucessfully
+bool bmp::unmap() {
+	return mapping.close();
+}
+
 bmp::bmp(std::string _filename)
 {
 	filename = _filename;
 }
 
 
-#undef assert
\ No newline at end of file
+#undef assert
@@ -1,8 +1,12 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
+#include <cstring>
+#include "framebuffer.hpp"
+#include "mapping.hpp"
 
 struct pixel{
 	pixel(int _r, int _g, int _b){
@@ -22,7 +26,8 @@ struct pixel{
 		g = _g;
 		b = _b;
 	}
-	unsigned char r,g,b;
+	//in the order a bmp stores them, so rows of pixels can be copied straight into the file
+	unsigned char b,g,r;
 };
 
 pixel operator +(pixel a,pixel b);
@@ -31,16 +36,16 @@ struct imgdata{
 	imgdata(int _width,int _height){
 		width = _width;
 		height = _height;
-		data = std::vector<std::vector<pixel>>(width, std::vector<pixel>(height,pixel(0)));
+		data = framebuffer<pixel>(width, height, pixel(0));
 	}
 	imgdata() {
 		width = 0;
 		height = 0;
-		data = std::vector<std::vector<pixel>>(width, std::vector<pixel>(height, pixel(0)));
 	}
 	int width;
 	int height;
-	std::vector<std::vector<pixel>> data;
+	//indexed data(x, y)
+	framebuffer<pixel> data;
 };
 
 class bmp
@@ -48,19 +53,31 @@ class bmp
 public:
 	bmp(std::string _filename);
 	std::string filename;
-	bool writeFile(imgdata imgdata);
+	bool writeFile(const imgdata& imgdata);
+	bool writeFile(framebufferView<const pixel> image);
+	bool begin(int _width, int _height);
+	bool writeRows(framebufferView<const pixel> rows);
+	bool finish();
+	framebufferView<pixel> map(int _width, int _height);
+	bool unmap();
+	static bool fits(int _width, int _height);
 private:
 	std::ofstream file;
-	imgdata data;
 	int width, height;
-	int filesize;
+	uint64_t filesize;
 	const int bmpheadersize = 14;
 	const int dibheadersize = 40;
-	int rowWidthBytes;
-	int arraysize;
+	std::size_t rowWidthBytes;
+	uint64_t arraysize;
+	//the whole file while it is mapped
+	mappedFile mapping;
+
+	bool setSize(int _width, int _height);
+	void writeHeader(char* out);
 
 	template<typename T>
-	void write(T val) {
-		file.write((char*)&val, sizeof(T));
+	void write(char*& out, T val) {
+		std::memcpy(out, &val, sizeof(T));
+		out += sizeof(T);
 	}
 };
@@ -1,23 +1,39 @@
 #include "complex.hpp"
 #include "isnanIEEE754.h"
-
-complex::complex(double _re, double _im) {
+#include "extended.hpp"
+
+//math on the parts is unqualified so the double-double and quad-double versions are found too
+using std::sqrt;
+using std::atan2;
+using std::abs;
+using std::sin;
+using std::cos;
+using std::sinh;
+using std::cosh;
+using std::log;
+using std::exp;
+
+template<typename T>
+basicComplex<T>::basicComplex(T _re, T _im) {
     re = _re;
     im = _im;
 }
-complex::complex() {
+template<typename T>
+basicComplex<T>::basicComplex() {
     re = 0;
     im = 0;
 }
-double re, im;
 
-double complex::size() {
+template<typename T>
+T basicComplex<T>::size() {
     return sqrt(re * re + im * im);
 }
-double complex::arg(){
+template<typename T>
+T basicComplex<T>::arg(){
     return atan2(im, re);
 }
-bool complex::operator == (complex a) {
+template<typename T>
+bool basicComplex<T>::operator == (basicComplex a) const {
     if (a.re == re && a.im == im) {
         return true;
     }
@@ -41,121 +57,124 @@ std::string string(complex a){
     return std::to_string(a.re) + " " + std::to_string(a.im) + "i";
 }
 
-complex abs(complex a ) {
-    return complex(std::abs(a.re), std::abs(a.im));
-}
-
-bool operator > (const complex& a,const complex& b){
-    if(a.re != b.re) return a.re > b.re;
-    else return a.im > b.im;
-}
-
-bool operator < (const complex& a,const complex& b){
-    if(a.re != b.re) return a.re < b.re;
-    else return a.im < b.im;
-}
-
-complex operator + (const complex& a,const complex& b) {
-    return complex(a.re + b.re, a.im + b.im);
-}
-
-complex operator + (const complex& a,const double& b) {
-    return complex(a.re + b, a.im);
-}
-
-complex operator += (const complex &a, const complex &b)
-{
-    return a + b;
-}
-
-complex operator - (const complex& a,const complex& b) {
-    return complex(a.re - b.re, a.im - b.im);
-}
-
-complex operator - (const complex& a,const double& b) {
-    return complex(a.re - b, a.im);
+template<typename T>
+basicComplex<T> abs(basicComplex<T> a ) {
+    return basicComplex<T>(abs(a.re), abs(a.im));
 }
 
-complex operator - (const double& a,const complex& b) {
-    return complex(a - b.re, -b.im);
+template<typename T>
+basicComplex<T> square(const basicComplex<T>& x) {
+    return basicComplex<T>((x.re * x.re) - (x.im * x.im), (x.im * x.re) + (x.re * x.im));
 }
 
-complex operator * (const complex& a,const complex& b) {
-    return complex((a.re * b.re) - (a.im * b.im), (a.im * b.re) + (a.re * b.im));
+template<typename T>
+basicComplex<T> sin(const basicComplex<T>& x){
+    return basicComplex<T>(sin(x.re)*cosh(x.im),cos(x.re)*sinh(x.im));
 }
 
-complex operator * (const complex& a,const double& b) {
-    return complex((a.re * b), (a.im * b));
+template<typename T>
+basicComplex<T> cos(const basicComplex<T>& x){
+    return basicComplex<T>(cos(x.re)*cosh(x.im),-sin(x.re)*sinh(x.im));
 }
 
-complex operator * (const double& a,const complex& b) {
-    return complex((a * b.re), (a * b.im));
-}
-
-complex operator / (const complex& a,const complex& b) {
-    double c = 1 / ((b.re * b.re) + (b.im * b.im));
-    return complex(((a.re * b.re) + (a.im * b.im)) * c, ((-a.re * b.im) + (a.im * b.re)) * c);
-}
-
-complex operator / (const complex& a,const double& b) {
-    return complex(a.re/b, a.im /b);
-}
-
-complex operator / (const double& a,const complex& b) {
-    complex c;
-    c.re = ((a * b.re)) / ((b.re * b.re) + (b.im * b.im));
-    c.im = ((-a * b.im)) / ((b.re * b.re) + (b.im * b.im));
-    return c;
-}
-
-complex sin(const complex& x){
-    return complex(sin(x.re)*cosh(x.im),cos(x.re)*sinh(x.im));
-}
-
-complex cos(const complex& x){
-    return complex(cos(x.re)*cosh(x.im),-sin(x.re)*sinh(x.im));
-}
-
-complex sec(const complex& x){
+template<typename T>
+basicComplex<T> sec(const basicComplex<T>& x){
     return 1/cos(x);
 }
 
-complex csc(const complex& x){
+template<typename T>
+basicComplex<T> csc(const basicComplex<T>& x){
     return 1/sin(x);
 }
 
-complex tan(const complex& x){
+template<typename T>
+basicComplex<T> tan(const basicComplex<T>& x){
     return sin(x)/cos(x);
 }
 
-complex cot(const complex& x){
+template<typename T>
+basicComplex<T> cot(const basicComplex<T>& x){
     return cos(x)/sin(x);
 }
 
-complex log(complex a,int m){
-    return complex(log(a.size()),a.arg() + (m * 2 * 3.14159265359));
+//sin and cos of the same value share all four real functions
+template<typename T>
+void sincos(const basicComplex<T>& x, basicComplex<T>& s, basicComplex<T>& c){
+    T sinre = sin(x.re);
+    T cosre = cos(x.re);
+    T coshim = cosh(x.im);
+    T sinhim = sinh(x.im);
+    s = basicComplex<T>(sinre * coshim, cosre * sinhim);
+    c = basicComplex<T>(cosre * coshim, -sinre * sinhim);
 }
 
-complex log(complex a){
-    return complex(log(a.size()),a.arg());
+template<typename T>
+basicComplex<T> log(basicComplex<T> a,int m){
+    return basicComplex<T>(log(a.size()),a.arg() + T(m * 2 * 3.14159265359));
 }
 
-complex logBase(complex a,int base){
-    return log(a)/log(base);
+template<typename T>
+basicComplex<T> log(basicComplex<T> a){
+    return basicComplex<T>(log(a.size()),a.arg());
 }
 
-complex pow(complex a, double b){
-    //return complex()
-    throw 0;
-} 
+template<typename T>
+basicComplex<T> logBase(basicComplex<T> a,int base){
+    return log(a)/log(basicComplex<T>(base));
+}
 
-//TODO:
-complex pow(complex a, complex b) {
-    if(a.im == 0){
-        return pow(a.re,b.re)*complex(cos(b.im),sin(b.im));
-    }
-    if(b.im == 0){
+template<typename T>
+basicComplex<T> exp(const basicComplex<T>& x){
+    T e = exp(x.re);
+    return basicComplex<T>(e * cos(x.im), e * sin(x.im));
+}
 
+/// @brief integer power using repeated squaring
+template<typename T>
+basicComplex<T> powi(basicComplex<T> a, int n){
+    if (n < 0) return 1 / powi(a, -n);
+    basicComplex<T> output = T(1);
+    while (n > 0) {
+        if (n & 1) output = output * a;
+        n >>= 1;
+        if (n > 0) a = square(a);
     }
-    throw 0;
-}
\ No newline at end of file
+    return output;
+}
+
+template<typename T>
+basicComplex<T> pow(basicComplex<T> a, double b){
+    if (b == int(b)) return powi(a, int(b));
+    return pow(a, basicComplex<T>(b));
+}
+
+template<typename T>
+basicComplex<T> pow(basicComplex<T> a, basicComplex<T> b) {
+    if (a.re == 0 && a.im == 0) return T(0);
+    return exp(b * log(a));
+}
+
+//everything is built for every precision a render can use
+#define INSTANTIATE_COMPLEX(T) \
+    template struct basicComplex<T>; \
+    template basicComplex<T> abs(basicComplex<T>); \
+    template basicComplex<T> square(const basicComplex<T>&); \
+    template basicComplex<T> sin(const basicComplex<T>&); \
+    template basicComplex<T> cos(const basicComplex<T>&); \
+    template basicComplex<T> sec(const basicComplex<T>&); \
+    template basicComplex<T> csc(const basicComplex<T>&); \
+    template basicComplex<T> tan(const basicComplex<T>&); \
+    template basicComplex<T> cot(const basicComplex<T>&); \
+    template void sincos(const basicComplex<T>&, basicComplex<T>&, basicComplex<T>&); \
+    template basicComplex<T> log(basicComplex<T>, int); \
+    template basicComplex<T> log(basicComplex<T>); \
+    template basicComplex<T> logBase(basicComplex<T>, int); \
+    template basicComplex<T> exp(const basicComplex<T>&); \
+    template basicComplex<T> powi(basicComplex<T>, int); \
+    template basicComplex<T> pow(basicComplex<T>, double); \
+    template basicComplex<T> pow(basicComplex<T>, basicComplex<T>);
+
+INSTANTIATE_COMPLEX(float)
+INSTANTIATE_COMPLEX(double)
+INSTANTIATE_COMPLEX(doubleDouble)
+INSTANTIATE_COMPLEX(quadDouble)
@@ -2,68 +2,131 @@
 #include <cmath>
 #include <string>
 
-struct complex {
-    complex(double _re, double _im = 0);
-    complex();
-    double re, im;
-
-    double size();
-    double arg();
-    bool operator == (complex a);
+/// @brief complex number with T (float or double) for each part. Everything else uses the double version, complex
+template<typename T>
+struct basicComplex {
+    basicComplex(T _re, T _im = 0);
+    basicComplex();
+    T re, im;
+
+    T size();
+    T arg();
+    bool operator == (basicComplex a) const;
+
+    //operators are defined here so numbers like 1 or 0.5 convert to T when used with them
+    friend bool operator > (const basicComplex& a,const basicComplex& b){
+        if(a.re != b.re) return a.re > b.re;
+        else return a.im > b.im;
+    }
+
+    friend bool operator < (const basicComplex& a,const basicComplex& b){
+        if(a.re != b.re) return a.re < b.re;
+        else return a.im < b.im;
+    }
+
+    friend basicComplex operator + (const basicComplex& a,const basicComplex& b) {
+        return basicComplex(a.re + b.re, a.im + b.im);
+    }
+
+    friend basicComplex operator + (const basicComplex& a,const T& b) {
+        return basicComplex(a.re + b, a.im);
+    }
+
+    friend basicComplex operator += (const basicComplex &a, const basicComplex &b) {
+        return a + b;
+    }
+
+    friend basicComplex operator - (const basicComplex& a,const basicComplex& b) {
+        return basicComplex(a.re - b.re, a.im - b.im);
+    }
+
+    friend basicComplex operator - (const basicComplex& a,const T& b) {
+        return basicComplex(a.re - b, a.im);
+    }
+
+    friend basicComplex operator - (const T& a,const basicComplex& b) {
+        return basicComplex(a - b.re, -b.im);
+    }
+
+    friend basicComplex operator * (const basicComplex& a,const basicComplex& b) {
+        return basicComplex((a.re * b.re) - (a.im * b.im), (a.im * b.re) + (a.re * b.im));
+    }
+
+    friend basicComplex operator * (const basicComplex& a,const T& b) {
+        return basicComplex((a.re * b), (a.im * b));
+    }
+
+    friend basicComplex operator * (const T& a,const basicComplex& b) {
+        return basicComplex((a * b.re), (a * b.im));
+    }
+
+    friend basicComplex operator / (const basicComplex& a,const basicComplex& b) {
+        T c = 1 / ((b.re * b.re) + (b.im * b.im));
+        return basicComplex(((a.re * b.re) + (a.im * b.im)) * c, ((-a.re * b.im) + (a.im * b.re)) * c);
+    }
+
+    friend basicComplex operator / (const basicComplex& a,const T& b) {
+        return basicComplex(a.re/b, a.im /b);
+    }
+
+    friend basicComplex operator / (const T& a,const basicComplex& b) {
+        basicComplex c;
+        c.re = ((a * b.re)) / ((b.re * b.re) + (b.im * b.im));
+        c.im = ((-a * b.im)) / ((b.re * b.re) + (b.im * b.im));
+        return c;
+    }
 };
 
+typedef basicComplex<double> complex;
+
 bool isnanIEEE754(complex a);
 
 std::string string(complex a);
 
-complex abs(complex a );
-
-bool operator > (const complex& a,const complex& b);
-
-bool operator < (const complex& a,const complex& b);
-
-complex operator + (const complex& a,const complex& b);
-
-complex operator + (const complex& a,const double& b);
-
-complex operator += (const complex& a,const complex& b);
-
-complex operator - (const complex& a,const complex& b);
-
-complex operator - (const complex& a,const double& b);
-
-complex operator - (const double& a,const complex& b);
-
-complex operator * (const complex& a,const complex& b);
-
-complex operator * (const complex& a,const double& b);
+template<typename T>
+basicComplex<T> abs(basicComplex<T> a );
 
-complex operator * (const double& a,const complex& b);
+template<typename T>
+basicComplex<T> square(const basicComplex<T>& x);
 
-complex operator / (const complex& a,const complex& b);
+template<typename T>
+basicComplex<T> sin(const basicComplex<T>& x);
 
-complex operator / (const complex& a,const double& b);
+template<typename T>
+basicComplex<T> cos(const basicComplex<T>& x);
 
-complex operator / (const double& a,const complex& b);
+template<typename T>
+basicComplex<T> sec(const basicComplex<T>& x);
 
-complex sin(const complex& x);
+template<typename T>
+basicComplex<T> csc(const basicComplex<T>& x);
 
-complex cos(const complex& x);
+template<typename T>
+basicComplex<T> tan(const basicComplex<T>& x);
 
-complex sec(const complex& x);
+template<typename T>
+basicComplex<T> cot(const basicComplex<T>& x);
 
-complex csc(const complex& x);
+template<typename T>
+void sincos(const basicComplex<T>& x, basicComplex<T>& s, basicComplex<T>& c);
 
-complex tan(const complex& x);
+template<typename T>
+basicComplex<T> log(basicComplex<T> a,int m);
 
-complex cot(const complex& x);
+template<typename T>
+basicComplex<T> log(basicComplex<T> a);
 
-complex log(complex a,int m);
+template<typename T>
+basicComplex<T> logBase(basicComplex<T> a,int base);
 
-complex log(complex a);
+template<typename T>
+basicComplex<T> exp(const basicComplex<T>& x);
 
-complex logBase(complex a,int base);
+template<typename T>
+basicComplex<T> powi(basicComplex<T> a, int n);
 
-complex pow(complex a, double b);
+template<typename T>
+basicComplex<T> pow(basicComplex<T> a, double b);
 
-complex pow(complex a, complex b);
\ No newline at end of file
+template<typename T>
+basicComplex<T> pow(basicComplex<T> a, basicComplex<T> b);
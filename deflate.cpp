@@ -0,0 +1,402 @@
+#include "deflate.hpp"
+#include <algorithm>
+#include <array>
+#include <queue>
+
+//bits of the hash of the next 3 bytes that matches are looked up by
+constexpr int HASH_BITS = 15;
+
+//most earlier positions with the same hash that are compared for each match, more finds longer matches but is slower
+constexpr int MAX_CHAIN = 64;
+
+constexpr int MIN_MATCH = 3;
+constexpr int MAX_MATCH = 258;
+
+//literals and matches in each block, each block gets huffman codes made for what is in it
+constexpr std::size_t BLOCK_SYMBOLS = 1 << 14;
+
+constexpr int LITLEN_CODES = 286;
+constexpr int DIST_CODES = 30;
+constexpr int END_OF_BLOCK = 256;
+
+//longest code for literals, lengths and distances, and for the codes the code lengths are sent with
+constexpr int MAX_BITS = 15;
+constexpr int MAX_LENGTH_BITS = 7;
+
+static const int lengthBase[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+static const int lengthExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+static const int distBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+static const int distExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+//order the lengths of the code length codes are sent in
+static const int lengthOrder[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+/// @brief a literal byte when distance is 0, otherwise a match of length bytes distance bytes back
+struct lzSymbol {
+    uint16_t value;
+    uint16_t distance;
+};
+
+/// @brief writes bits to the end of a vector, first bit in the lowest bit of each byte like deflate wants
+struct bitWriter {
+    std::vector<unsigned char>& out;
+    uint64_t bits = 0;
+    int count = 0;
+
+    void write(uint32_t value, int n) {
+        bits |= uint64_t(value) << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back((unsigned char)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    //pad to the end of the byte with 0s
+    void align() {
+        if (count > 0)
+            write(0, 8 - count);
+    }
+};
+
+/// @return index of the length code for a match length
+static int lengthCode(int length) {
+    return int(std::upper_bound(lengthBase, lengthBase + 29, length) - lengthBase) - 1;
+}
+
+/// @return index of the distance code for a match distance
+static int distCode(int distance) {
+    return int(std::upper_bound(distBase, distBase + 30, distance) - distBase) - 1;
+}
+
+/// @brief Work out huffman code lengths for the symbols, no longer than maxBits. While the tree is too deep the
+/// counts are halved, which flattens it, like older encoders do
+/// @param counts how many times each symbol is used
+/// @return length of the code of each symbol, 0 for symbols that aren't used. At least 2 symbols get a code since
+/// some decoders don't take a tree with one
+static std::vector<int> codeLengths(std::vector<uint32_t> counts, int maxBits) {
+    int used = int(std::count_if(counts.begin(), counts.end(), [](uint32_t c) { return c > 0; }));
+    for (std::size_t i = 0; i < counts.size() && used < 2; i++) {
+        if (counts[i] == 0) {
+            counts[i] = 1;
+            used++;
+        }
+    }
+    std::vector<int> lengths(counts.size(), 0);
+    while (true) {
+        //leaves are the symbols, then each node made joins the two lightest left
+        std::vector<int> parent;
+        std::vector<int> leaf(counts.size(), -1);
+        typedef std::pair<uint64_t, int> node;
+        std::priority_queue<node, std::vector<node>, std::greater<node>> queue;
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] > 0) {
+                leaf[i] = int(parent.size());
+                queue.push({ counts[i], int(parent.size()) });
+                parent.push_back(-1);
+            }
+        }
+        while (queue.size() > 1) {
+            node a = queue.top();
+            queue.pop();
+            node b = queue.top();
+            queue.pop();
+            int joined = int(parent.size());
+            parent.push_back(-1);
+            parent[a.second] = joined;
+            parent[b.second] = joined;
+            queue.push({ a.first + b.first, joined });
+        }
+        //parents always come after their children, so depths can be filled from the root down
+        std::vector<int> depth(parent.size(), 0);
+        for (int n = int(parent.size()) - 2; n >= 0; n--)
+            depth[n] = depth[parent[n]] + 1;
+        int deepest = 0;
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            lengths[i] = leaf[i] >= 0 ? depth[leaf[i]] : 0;
+            deepest = std::max(deepest, lengths[i]);
+        }
+        if (deepest <= maxBits)
+            return lengths;
+        for (uint32_t& c : counts)
+            if (c > 0)
+                c = std::max<uint32_t>(c / 2, 1);
+    }
+}
+
+/// @return canonical huffman codes for the lengths, with the bits reversed so they can be written first bit lowest
+static std::vector<uint32_t> canonicalCodes(const std::vector<int>& lengths) {
+    int lengthCount[MAX_BITS + 1] = { 0 };
+    for (int l : lengths)
+        lengthCount[l]++;
+    lengthCount[0] = 0;
+    uint32_t next[MAX_BITS + 2] = { 0 };
+    uint32_t code = 0;
+    for (int bits = 1; bits <= MAX_BITS; bits++) {
+        code = (code + lengthCount[bits - 1]) << 1;
+        next[bits] = code;
+    }
+    std::vector<uint32_t> codes(lengths.size(), 0);
+    for (std::size_t i = 0; i < lengths.size(); i++) {
+        int l = lengths[i];
+        if (l == 0)
+            continue;
+        uint32_t c = next[l]++;
+        uint32_t reversed = 0;
+        for (int b = 0; b < l; b++)
+            reversed |= ((c >> b) & 1) << (l - 1 - b);
+        codes[i] = reversed;
+    }
+    return codes;
+}
+
+/// @brief a code length, or 16, 17 or 18 to repeat one, with the extra bits that say how many times
+struct lengthSymbol {
+    int symbol;
+    int extra;
+    int extraBits;
+};
+
+/// @return the code lengths of a block run length encoded the way deflate sends them
+static std::vector<lengthSymbol> encodeLengths(const std::vector<int>& lengths) {
+    std::vector<lengthSymbol> out;
+    for (std::size_t i = 0; i < lengths.size();) {
+        int value = lengths[i];
+        int run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == value)
+            run++;
+        i += run;
+        if (value == 0) {
+            while (run >= 11) {
+                int n = std::min(run, 138);
+                out.push_back({ 18, n - 11, 7 });
+                run -= n;
+            }
+            if (run >= 3) {
+                out.push_back({ 17, run - 3, 3 });
+                run = 0;
+            }
+        }
+        else {
+            out.push_back({ value, 0, 0 });
+            run--;
+            while (run >= 3) {
+                int n = std::min(run, 6);
+                out.push_back({ 16, n - 3, 2 });
+                run -= n;
+            }
+        }
+        for (; run > 0; run--)
+            out.push_back({ value, 0, 0 });
+    }
+    return out;
+}
+
+/// @brief Write a block with huffman codes made for the symbols in it
+static void writeBlock(bitWriter& writer, const lzSymbol* symbols, std::size_t count, bool final) {
+    std::vector<uint32_t> litlenCounts(LITLEN_CODES, 0);
+    std::vector<uint32_t> distCounts(DIST_CODES, 0);
+    for (std::size_t i = 0; i < count; i++) {
+        if (symbols[i].distance == 0) {
+            litlenCounts[symbols[i].value]++;
+        }
+        else {
+            litlenCounts[257 + lengthCode(symbols[i].value)]++;
+            distCounts[distCode(symbols[i].distance)]++;
+        }
+    }
+    litlenCounts[END_OF_BLOCK] = 1;
+    std::vector<int> litlenLengths = codeLengths(litlenCounts, MAX_BITS);
+    std::vector<int> distLengths = codeLengths(distCounts, MAX_BITS);
+    std::vector<uint32_t> litlenCodes = canonicalCodes(litlenLengths);
+    std::vector<uint32_t> distCodes = canonicalCodes(distLengths);
+
+    //trailing unused codes aren't sent
+    int litlenSent = LITLEN_CODES;
+    while (litlenSent > 257 && litlenLengths[litlenSent - 1] == 0)
+        litlenSent--;
+    int distSent = DIST_CODES;
+    while (distSent > 1 && distLengths[distSent - 1] == 0)
+        distSent--;
+    std::vector<int> allLengths(litlenLengths.begin(), litlenLengths.begin() + litlenSent);
+    allLengths.insert(allLengths.end(), distLengths.begin(), distLengths.begin() + distSent);
+    std::vector<lengthSymbol> encoded = encodeLengths(allLengths);
+
+    std::vector<uint32_t> lengthCounts(19, 0);
+    for (const lengthSymbol& s : encoded)
+        lengthCounts[s.symbol]++;
+    std::vector<int> lengthLengths = codeLengths(lengthCounts, MAX_LENGTH_BITS);
+    std::vector<uint32_t> lengthCodes = canonicalCodes(lengthLengths);
+    int lengthsSent = 19;
+    while (lengthsSent > 4 && lengthLengths[lengthOrder[lengthsSent - 1]] == 0)
+        lengthsSent--;
+
+    writer.write(final ? 1 : 0, 1);
+    writer.write(2, 2);
+    writer.write(litlenSent - 257, 5);
+    writer.write(distSent - 1, 5);
+    writer.write(lengthsSent - 4, 4);
+    for (int i = 0; i < lengthsSent; i++)
+        writer.write(lengthLengths[lengthOrder[i]], 3);
+    for (const lengthSymbol& s : encoded) {
+        writer.write(lengthCodes[s.symbol], lengthLengths[s.symbol]);
+        if (s.extraBits > 0)
+            writer.write(s.extra, s.extraBits);
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        const lzSymbol& s = symbols[i];
+        if (s.distance == 0) {
+            writer.write(litlenCodes[s.value], litlenLengths[s.value]);
+            continue;
+        }
+        int l = lengthCode(s.value);
+        writer.write(litlenCodes[257 + l], litlenLengths[257 + l]);
+        if (lengthExtra[l] > 0)
+            writer.write(s.value - lengthBase[l], lengthExtra[l]);
+        int d = distCode(s.distance);
+        writer.write(distCodes[d], distLengths[d]);
+        if (distExtra[d] > 0)
+            writer.write(s.distance - distBase[d], distExtra[d]);
+    }
+    writer.write(litlenCodes[END_OF_BLOCK], litlenLengths[END_OF_BLOCK]);
+}
+
+static inline uint32_t hash3(const unsigned char* p) {
+    uint32_t v = uint32_t(p[0]) << 16 | uint32_t(p[1]) << 8 | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/// @brief Find matches in data greedily, positions are counted from the start of the history
+static std::vector<lzSymbol> findMatches(const unsigned char* data, std::size_t size, std::size_t history) {
+    const unsigned char* window = data - history;
+    std::size_t total = history + size;
+    std::vector<int32_t> head(std::size_t(1) << HASH_BITS, -1);
+    std::vector<int32_t> previous(total, -1);
+    auto insert = [&](std::size_t pos) {
+        if (pos + MIN_MATCH > total)
+            return;
+        uint32_t h = hash3(window + pos);
+        previous[pos] = head[h];
+        head[h] = int32_t(pos);
+    };
+    for (std::size_t pos = 0; pos < history; pos++)
+        insert(pos);
+
+    std::vector<lzSymbol> symbols;
+    symbols.reserve(size / 2);
+    for (std::size_t pos = history; pos < total;) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (pos + MIN_MATCH <= total) {
+            int longest = int(std::min<std::size_t>(MAX_MATCH, total - pos));
+            int32_t candidate = head[hash3(window + pos)];
+            for (int chain = 0; candidate >= 0 && chain < MAX_CHAIN && pos - candidate <= DEFLATE_WINDOW; chain++) {
+                const unsigned char* a = window + candidate;
+                const unsigned char* b = window + pos;
+                //only a match that is longer than the best so far can be better, check the byte that decides that first
+                if (a[bestLength] == b[bestLength] || bestLength == 0) {
+                    int length = 0;
+                    while (length < longest && a[length] == b[length])
+                        length++;
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = int(pos - candidate);
+                        if (length == longest)
+                            break;
+                    }
+                }
+                candidate = previous[candidate];
+            }
+        }
+        if (bestLength >= MIN_MATCH) {
+            symbols.push_back({ uint16_t(bestLength), uint16_t(bestDistance) });
+            for (int k = 0; k < bestLength; k++)
+                insert(pos + k);
+            pos += bestLength;
+        }
+        else {
+            symbols.push_back({ window[pos], 0 });
+            insert(pos);
+            pos++;
+        }
+    }
+    return symbols;
+}
+
+std::vector<unsigned char> deflatePiece(const unsigned char* data, std::size_t size, std::size_t history, bool last) {
+    history = std::min(history, DEFLATE_WINDOW);
+    std::vector<lzSymbol> symbols = findMatches(data, size, history);
+    std::vector<unsigned char> out;
+    out.reserve(size / 2 + 64);
+    bitWriter writer{ out };
+    for (std::size_t first = 0; first < symbols.size(); first += BLOCK_SYMBOLS) {
+        std::size_t count = std::min(BLOCK_SYMBOLS, symbols.size() - first);
+        writeBlock(writer, symbols.data() + first, count, last && first + count == symbols.size());
+    }
+    if (last && symbols.empty()) {
+        //a final fixed huffman block with only the end of block code, which is 7 zero bits
+        writer.write(1, 1);
+        writer.write(1, 2);
+        writer.write(0, 7);
+    }
+    if (!last) {
+        //sync flush, an empty stored block brings the stream to a byte boundary
+        writer.write(0, 3);
+        writer.align();
+        out.insert(out.end(), { 0x00, 0x00, 0xFF, 0xFF });
+    }
+    writer.align();
+    return out;
+}
+
+uint32_t crc32(const unsigned char* data, std::size_t size, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t;
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+//largest prime below 2^16
+constexpr uint32_t ADLER_BASE = 65521;
+
+uint32_t adler32(const unsigned char* data, std::size_t size, uint32_t adler) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        //the most bytes that can be added before b has to be reduced to not overflow
+        std::size_t n = std::min<std::size_t>(size, 5552);
+        size -= n;
+        for (; n > 0; n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return b << 16 | a;
+}
+
+uint32_t adler32Combine(uint32_t first, uint32_t second, std::size_t secondSize) {
+    uint32_t remainder = uint32_t(secondSize % ADLER_BASE);
+    uint32_t a = first & 0xFFFF;
+    uint32_t b = uint32_t((uint64_t(remainder) * a) % ADLER_BASE);
+    a += (second & 0xFFFF) + ADLER_BASE - 1;
+    b += (first >> 16) + (second >> 16) + ADLER_BASE - remainder;
+    if (a >= ADLER_BASE) a -= ADLER_BASE;
+    if (a >= ADLER_BASE) a -= ADLER_BASE;
+    if (b >= ADLER_BASE * 2) b -= ADLER_BASE * 2;
+    if (b >= ADLER_BASE) b -= ADLER_BASE;
+    return b << 16 | a;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief bytes before data that matches can go back into, the most a deflate stream can look back
+constexpr std::size_t DEFLATE_WINDOW = 32768;
+
+/// @brief Compress one piece of a deflate stream. Pieces are independent, so each can be compressed on a different
+/// thread and the results joined in order like pigz does. Every piece but the last ends on a byte with a sync flush,
+/// an empty stored block, so the next one can start right after it
+/// @param data bytes to compress
+/// @param history bytes right before data that can be matched, up to DEFLATE_WINDOW, the end of the piece before
+/// @param last set the final block bit so the stream ends with this piece
+/// @return compressed bytes, with no zlib header or checksum
+std::vector<unsigned char> deflatePiece(const unsigned char* data, std::size_t size, std::size_t history, bool last);
+
+/// @return crc of the bytes, start with 0 or the crc of the bytes before them
+uint32_t crc32(const unsigned char* data, std::size_t size, uint32_t crc = 0);
+
+/// @return adler-32 checksum of the bytes, start with 1 or the checksum of the bytes before them
+uint32_t adler32(const unsigned char* data, std::size_t size, uint32_t adler = 1);
+
+/// @return adler-32 checksum of two pieces joined, from the checksum of each and the size of the second
+uint32_t adler32Combine(uint32_t first, uint32_t second, std::size_t secondSize);
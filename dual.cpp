@@ -0,0 +1,59 @@
+#include "dual.hpp"
+
+dual::dual(complex _value, complex _derivative) {
+    value = _value;
+    derivative = _derivative;
+}
+dual::dual() {
+    value = 0;
+    derivative = 0;
+}
+
+dual operator + (const dual& a,const dual& b) {
+    return dual(a.value + b.value, a.derivative + b.derivative);
+}
+
+dual operator - (const dual& a,const dual& b) {
+    return dual(a.value - b.value, a.derivative - b.derivative);
+}
+
+dual operator * (const dual& a,const dual& b) {
+    return dual(a.value * b.value, (a.derivative * b.value) + (a.value * b.derivative));
+}
+
+dual operator / (const dual& a,const dual& b) {
+    complex value = a.value / b.value;
+    return dual(value, (a.derivative - (value * b.derivative)) / b.value);
+}
+
+dual operator / (const double& a,const dual& b) {
+    complex value = a / b.value;
+    return dual(value, (0 - value) * (b.derivative / b.value));
+}
+
+dual square(const dual& x){
+    return dual(square(x.value), (x.derivative * x.value) + (x.value * x.derivative));
+}
+
+void sincos(const dual& x, dual& s, dual& c){
+    complex sinx, cosx;
+    sincos(x.value, sinx, cosx);
+    s = dual(sinx, cosx * x.derivative);
+    c = dual(cosx, (0 - sinx) * x.derivative);
+}
+
+dual log(const dual& x){
+    return dual(log(x.value), x.derivative / x.value);
+}
+
+//(x^n)' = n*x^(n-1)*x'
+dual powi(const dual& x, int n){
+    complex previous = powi(x.value, n - 1);
+    return dual(previous * x.value, (n * previous) * x.derivative);
+}
+
+//(a^b)' = a^b*(b'*ln(a) + b*a'/a)
+dual pow(const dual& a, const dual& b){
+    complex value = pow(a.value, b.value);
+    return dual(value, value * ((b.derivative * log(a.value)) + (b.value * (a.derivative / a.value))));
+}
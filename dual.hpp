@@ -0,0 +1,29 @@
+#pragma once
+#include "complex.hpp"
+
+/// @brief a value and its derivative with respect to the function variable, used for forward mode differentiation
+struct dual {
+    dual(complex _value, complex _derivative = 0);
+    dual();
+    complex value, derivative;
+};
+
+dual operator + (const dual& a,const dual& b);
+
+dual operator - (const dual& a,const dual& b);
+
+dual operator * (const dual& a,const dual& b);
+
+dual operator / (const dual& a,const dual& b);
+
+dual operator / (const double& a,const dual& b);
+
+dual square(const dual& x);
+
+void sincos(const dual& x, dual& s, dual& c);
+
+dual log(const dual& x);
+
+dual powi(const dual& x, int n);
+
+dual pow(const dual& a, const dual& b);
@@ -0,0 +1,233 @@
+#include <vector>
+#include "extended.hpp"
+
+/// @brief the series below stop here even if they haven't reached full precision, which only happens for NAN or INFINITY
+constexpr auto MAX_SERIES_TERMS = 64;
+
+//constants to 4 limbs, smaller precisions use the first N
+static const double PI[4] = { 0x1.921fb54442d18p+1, 0x1.1a62633145c07p-53, -0x1.f1976b7ed8fbcp-109, 0x1.4cf98e804177dp-163 };
+static const double LN2[4] = { 0x1.62e42fefa39efp-1, 0x1.abc9e3b39803fp-56, 0x1.7b57a079a1934p-111, -0x1.ace93a4ebe5d1p-165 };
+
+template<int N>
+static multiDouble<N> constant(const double (&limbs)[4]) {
+    multiDouble<N> output;
+    for (int i = 0; i < N; i++)
+        output.limb[i] = limbs[i];
+    return output;
+}
+
+/// @return a * 2^n, exact
+template<int N>
+static multiDouble<N> ldexp(multiDouble<N> a, int n) {
+    for (int i = 0; i < N; i++)
+        a.limb[i] = std::ldexp(a.limb[i], n);
+    return a;
+}
+
+/// @return 1/n! for the series below, worked out once
+template<int N>
+static const multiDouble<N>& inverseFactorial(int n) {
+    static const std::vector<multiDouble<N>> table = [] {
+        std::vector<multiDouble<N>> output(MAX_SERIES_TERMS);
+        output[0] = 1;
+        for (int i = 1; i < MAX_SERIES_TERMS; i++)
+            output[i] = output[i - 1] / i;
+        return output;
+    }();
+    return table[n];
+}
+
+/// @return number of newton iterations to go from a double to N limbs, each one doubles the bits
+template<int N>
+static int refinements() {
+    int iterations = 0;
+    for (int bits = 53; bits < 53 * N; bits *= 2)
+        iterations++;
+    return iterations;
+}
+
+template<int N>
+multiDouble<N> parseMultiDouble(const std::string& input) {
+    multiDouble<N> output = 0;
+    int i = 0;
+    bool negative = false;
+    if (i < input.size() && (input[i] == '-' || input[i] == '+')) {
+        negative = input[i] == '-';
+        i++;
+    }
+    int exponent = 0;
+    bool fraction = false;
+    for (; i < input.size(); i++) {
+        if (input[i] == '.') {
+            fraction = true;
+        }
+        else if (input[i] >= '0' && input[i] <= '9') {
+            output = output * 10 + (input[i] - '0');
+            if (fraction) exponent--;
+        }
+        else if (input[i] == 'e' || input[i] == 'E') {
+            exponent += std::stoi(input.substr(i + 1));
+            break;
+        }
+        else {
+            break;
+        }
+    }
+    multiDouble<N> power = 1;
+    for (int j = 0; j < std::abs(exponent); j++)
+        power = power * 10;
+    output = exponent < 0 ? output / power : output * power;
+    return negative ? -output : output;
+}
+
+template<int N>
+multiDouble<N> abs(const multiDouble<N>& a) {
+    return a.limb[0] < 0 ? -a : a;
+}
+
+template<int N>
+multiDouble<N> sqrt(const multiDouble<N>& a) {
+    if (a.limb[0] <= 0) return std::sqrt(a.limb[0]);
+    multiDouble<N> x = std::sqrt(a.limb[0]);
+    for (int i = 0; i < refinements<N>(); i++)
+        x = ldexp(x + a / x, -1);
+    return x;
+}
+
+//exp(a) = 2^k * exp(r) where r = a - k*ln(2) is made even smaller by a power of 2. The series is done for exp(r) - 1
+//so no bits are lost to the 1, then undone with (exp(2r) - 1) = (exp(r) - 1)(exp(r) - 1 + 2)
+template<int N>
+multiDouble<N> exp(const multiDouble<N>& a) {
+    constexpr int halvings = 8;
+    if (a.limb[0] > 709) return INFINITY;
+    if (a.limb[0] < -745) return 0;
+    double k = std::round(a.limb[0] / LN2[0]);
+    multiDouble<N> r = ldexp(a - constant<N>(LN2) * k, -halvings);
+
+    multiDouble<N> epsilon = std::numeric_limits<multiDouble<N>>::epsilon();
+    multiDouble<N> power = r;
+    multiDouble<N> term = r;
+    multiDouble<N> sum = r;
+    for (int i = 2; i < MAX_SERIES_TERMS && abs(term) > epsilon * abs(sum); i++) {
+        power = power * r;
+        term = power * inverseFactorial<N>(i);
+        sum = sum + term;
+    }
+    for (int i = 0; i < halvings; i++)
+        sum = sum * (sum + 2);
+    return ldexp(sum + 1, int(k));
+}
+
+//newton's method on exp(y) - a
+template<int N>
+multiDouble<N> log(const multiDouble<N>& a) {
+    if (a.limb[0] <= 0) return std::log(a.limb[0]);
+    multiDouble<N> y = std::log(a.limb[0]);
+    for (int i = 0; i < refinements<N>(); i++)
+        y = y + a * exp(-y) - 1;
+    return y;
+}
+
+//series for both after reducing a to within pi/4 of a multiple of pi/2
+template<int N>
+void sincos(const multiDouble<N>& a, multiDouble<N>& s, multiDouble<N>& c) {
+    multiDouble<N> pi = constant<N>(PI);
+    multiDouble<N> halfPi = ldexp(pi, -1);
+    multiDouble<N> r = a - ldexp(pi, 1) * std::round(a.limb[0] / (2 * PI[0]));
+    double quarter = std::round(r.limb[0] / (PI[0] / 2));
+    r = r - halfPi * quarter;
+
+    multiDouble<N> epsilon = std::numeric_limits<multiDouble<N>>::epsilon();
+    multiDouble<N> square = r * r;
+    multiDouble<N> power = r;
+    multiDouble<N> term = r;
+    multiDouble<N> sine = r;
+    multiDouble<N> cosine = 1;
+    for (int i = 2; i < MAX_SERIES_TERMS - 1 && abs(term) > epsilon; i += 2) {
+        term = (power * r) * inverseFactorial<N>(i);
+        cosine = (i / 2) % 2 ? cosine - term : cosine + term;
+        power = power * square;
+        term = power * inverseFactorial<N>(i + 1);
+        sine = (i / 2) % 2 ? sine - term : sine + term;
+    }
+
+    switch (((int(quarter) % 4) + 4) % 4) {
+    case 0:
+        s = sine;
+        c = cosine;
+        break;
+    case 1:
+        s = cosine;
+        c = -sine;
+        break;
+    case 2:
+        s = -sine;
+        c = -cosine;
+        break;
+    default:
+        s = -cosine;
+        c = sine;
+        break;
+    }
+}
+
+template<int N>
+multiDouble<N> sin(const multiDouble<N>& a) {
+    multiDouble<N> s, c;
+    sincos(a, s, c);
+    return s;
+}
+
+template<int N>
+multiDouble<N> cos(const multiDouble<N>& a) {
+    multiDouble<N> s, c;
+    sincos(a, s, c);
+    return c;
+}
+
+template<int N>
+multiDouble<N> sinh(const multiDouble<N>& a) {
+    multiDouble<N> e = exp(a);
+    return ldexp(e - 1 / e, -1);
+}
+
+template<int N>
+multiDouble<N> cosh(const multiDouble<N>& a) {
+    multiDouble<N> e = exp(a);
+    return ldexp(e + 1 / e, -1);
+}
+
+//newton's method on the angle, moving along whichever of sin or cos changes fastest there
+template<int N>
+multiDouble<N> atan2(const multiDouble<N>& y, const multiDouble<N>& x) {
+    if (x.limb[0] == 0 && y.limb[0] == 0) return 0;
+    multiDouble<N> z = std::atan2(y.limb[0], x.limb[0]);
+    multiDouble<N> r = sqrt(x * x + y * y);
+    multiDouble<N> xx = x / r;
+    multiDouble<N> yy = y / r;
+    for (int i = 0; i < refinements<N>(); i++) {
+        multiDouble<N> s, c;
+        sincos(z, s, c);
+        if (std::abs(xx.limb[0]) > std::abs(yy.limb[0]))
+            z = z + (yy - s) / c;
+        else
+            z = z - (xx - c) / s;
+    }
+    return z;
+}
+
+#define INSTANTIATE_MULTI_DOUBLE(N) \
+    template multiDouble<N> parseMultiDouble<N>(const std::string&); \
+    template multiDouble<N> abs(const multiDouble<N>&); \
+    template multiDouble<N> sqrt(const multiDouble<N>&); \
+    template multiDouble<N> exp(const multiDouble<N>&); \
+    template multiDouble<N> log(const multiDouble<N>&); \
+    template void sincos(const multiDouble<N>&, multiDouble<N>&, multiDouble<N>&); \
+    template multiDouble<N> sin(const multiDouble<N>&); \
+    template multiDouble<N> cos(const multiDouble<N>&); \
+    template multiDouble<N> sinh(const multiDouble<N>&); \
+    template multiDouble<N> cosh(const multiDouble<N>&); \
+    template multiDouble<N> atan2(const multiDouble<N>&, const multiDouble<N>&);
+
+INSTANTIATE_MULTI_DOUBLE(2)
+INSTANTIATE_MULTI_DOUBLE(4)
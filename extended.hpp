@@ -0,0 +1,291 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+/// @brief stops the compiler from knowing anything about v. Fast math would otherwise rearrange the
+/// rounding error terms below, like ((a + b) - a) - b, into 0
+inline void opaque(double& v) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    asm("" : "+x"(v));
+#elif defined(__GNUC__)
+    asm("" : "+m"(v));
+#endif
+}
+
+/// @return a + b rounded to a double
+/// @param error set to the exact rounding error, so a + b = return value + error
+inline double twoSum(double a, double b, double& error) {
+    double s = a + b;
+    opaque(s);
+    double bb = s - a;
+    opaque(bb);
+    double aa = s - bb;
+    opaque(aa);
+    double errorA = a - aa;
+    double errorB = b - bb;
+    opaque(errorA);
+    opaque(errorB);
+    error = errorA + errorB;
+    return s;
+}
+
+/// @brief twoSum for when |a| >= |b|, which needs fewer steps
+inline double quickTwoSum(double a, double b, double& error) {
+    double s = a + b;
+    opaque(s);
+    double bb = s - a;
+    opaque(bb);
+    error = b - bb;
+    return s;
+}
+
+/// @return a * b rounded to a double
+/// @param error set to the exact rounding error, so a * b = return value + error
+inline double twoProduct(double a, double b, double& error) {
+    double p = a * b;
+    opaque(p);
+    error = std::fma(a, b, -p);
+    return p;
+}
+
+/// @brief a number stored as the unevaluated sum of N doubles, each one holding what is left over from
+/// the ones before it. multiDouble<2> (double-double) has about 106 bits and multiDouble<4> (quad-double) about 212
+template<int N>
+struct multiDouble {
+    double limb[N];
+
+    multiDouble(double v = 0) {
+        limb[0] = v;
+        for (int i = 1; i < N; i++)
+            limb[i] = 0;
+    }
+
+    /// @brief converts between precisions, extra limbs are dropped or filled with 0
+    template<int M>
+    explicit multiDouble(const multiDouble<M>& v) {
+        for (int i = 0; i < N; i++)
+            limb[i] = i < M ? v.limb[i] : 0;
+    }
+
+    /// @brief the first limb is the value rounded to a double
+    explicit operator double() const {
+        return limb[0];
+    }
+
+    multiDouble operator - () const {
+        multiDouble output;
+        for (int i = 0; i < N; i++)
+            output.limb[i] = -limb[i];
+        return output;
+    }
+
+    //operators are defined here so numbers like 1 or 0.5 convert to multiDouble when used with them.
+    //double-double has shorter versions of each that skip the general renormalization
+    friend multiDouble operator + (const multiDouble& a, const multiDouble& b) {
+        if constexpr (N == 2) {
+            double e, f;
+            double s = twoSum(a.limb[0], b.limb[0], e);
+            double t = twoSum(a.limb[1], b.limb[1], f);
+            e += t;
+            s = quickTwoSum(s, e, e);
+            e += f;
+            multiDouble output;
+            output.limb[0] = quickTwoSum(s, e, output.limb[1]);
+            return output;
+        }
+        double terms[2 * N];
+        for (int i = 0; i < N; i++) {
+            terms[2 * i] = a.limb[i];
+            terms[2 * i + 1] = b.limb[i];
+        }
+        return renormalize(terms);
+    }
+
+    friend multiDouble operator - (const multiDouble& a, const multiDouble& b) {
+        return a + -b;
+    }
+
+    //every product of limbs that can reach the last limb, with the rounding error of each one that isn't in the last limb
+    friend multiDouble operator * (const multiDouble& a, const multiDouble& b) {
+        if constexpr (N == 2) {
+            double e;
+            double p = twoProduct(a.limb[0], b.limb[0], e);
+            e += (a.limb[0] * b.limb[1]) + (a.limb[1] * b.limb[0]);
+            multiDouble output;
+            output.limb[0] = quickTwoSum(p, e, output.limb[1]);
+            return output;
+        }
+        double terms[N * N];
+        int n = 0;
+        for (int order = 0; order < N; order++) {
+            for (int i = 0; i <= order; i++) {
+                if (order < N - 1) {
+                    terms[n] = twoProduct(a.limb[i], b.limb[order - i], terms[n + 1]);
+                    n += 2;
+                }
+                else {
+                    terms[n++] = a.limb[i] * b.limb[order - i];
+                }
+            }
+        }
+        return renormalize(terms);
+    }
+
+    //long division, one double of the quotient at a time
+    friend multiDouble operator / (const multiDouble& a, const multiDouble& b) {
+        if constexpr (N == 2) {
+            double q = a.limb[0] / b.limb[0];
+            multiDouble remainder = a - b * q;
+            multiDouble output;
+            output.limb[0] = quickTwoSum(q, remainder.limb[0] / b.limb[0], output.limb[1]);
+            return output;
+        }
+        double quotient[N + 1];
+        multiDouble remainder = a;
+        for (int i = 0; i <= N; i++) {
+            quotient[i] = remainder.limb[0] / b.limb[0];
+            remainder = remainder - b * quotient[i];
+        }
+        return renormalize(quotient);
+    }
+
+    friend multiDouble& operator += (multiDouble& a, const multiDouble& b) {
+        return a = a + b;
+    }
+
+    friend multiDouble& operator -= (multiDouble& a, const multiDouble& b) {
+        return a = a - b;
+    }
+
+    friend multiDouble& operator *= (multiDouble& a, const multiDouble& b) {
+        return a = a * b;
+    }
+
+    friend multiDouble& operator /= (multiDouble& a, const multiDouble& b) {
+        return a = a / b;
+    }
+
+    friend bool operator == (const multiDouble& a, const multiDouble& b) {
+        for (int i = 0; i < N; i++)
+            if (a.limb[i] != b.limb[i]) return false;
+        return true;
+    }
+
+    friend bool operator != (const multiDouble& a, const multiDouble& b) {
+        return !(a == b);
+    }
+
+    friend bool operator < (const multiDouble& a, const multiDouble& b) {
+        for (int i = 0; i < N; i++)
+            if (a.limb[i] != b.limb[i]) return a.limb[i] < b.limb[i];
+        return false;
+    }
+
+    friend bool operator > (const multiDouble& a, const multiDouble& b) {
+        return b < a;
+    }
+
+    friend bool operator <= (const multiDouble& a, const multiDouble& b) {
+        return !(b < a);
+    }
+
+    friend bool operator >= (const multiDouble& a, const multiDouble& b) {
+        return !(a < b);
+    }
+
+    /// @brief turns M doubles into N limbs that don't overlap
+    template<int M>
+    static multiDouble renormalize(double (&terms)[M]) {
+        //largest first. Limbs that don't fill all 53 bits can put a later term above an earlier one,
+        //which would otherwise leave the errors below out of order and the limbs overlapping
+        for (int i = 1; i < M; i++) {
+            double t = terms[i];
+            int j = i;
+            for (; j > 0 && std::abs(terms[j - 1]) < std::abs(t); j--)
+                terms[j] = terms[j - 1];
+            terms[j] = t;
+        }
+
+        //sum from the smallest up, afterwards terms[0] is the rounded sum and the rest are the exact errors
+        double s = terms[M - 1];
+        for (int i = M - 2; i >= 0; i--)
+            s = twoSum(terms[i], s, terms[i + 1]);
+        terms[0] = s;
+
+        //then take the limbs from the top, skipping errors that come out as 0
+        multiDouble output;
+        int k = 0;
+        for (int i = 1; i < M; i++) {
+            if (k == N - 1) {
+                s += terms[i];
+                continue;
+            }
+            double error;
+            s = twoSum(s, terms[i], error);
+            if (error != 0) {
+                output.limb[k++] = s;
+                s = error;
+            }
+        }
+        output.limb[k] = s;
+        return output;
+    }
+};
+
+typedef multiDouble<2> doubleDouble;
+typedef multiDouble<4> quadDouble;
+
+namespace std {
+    template<int N>
+    class numeric_limits<multiDouble<N>> : public numeric_limits<double> {
+    public:
+        static constexpr int digits = 53 * N;
+        static multiDouble<N> epsilon() { return std::ldexp(1.0, -52 * N); }
+    };
+}
+
+/// @return weather v is neither NAN nor infinite, see isfiniteLane in batch.hpp
+template<int N>
+inline bool isfiniteLane(const multiDouble<N>& v) {
+    uint64_t i;
+    std::memcpy(&i, &v.limb[0], sizeof(double));
+    return (i & 0x7FF0000000000000) != 0x7FF0000000000000;
+}
+
+/// @brief reads a decimal number like "-1.25e-30" with every digit that fits in N limbs
+template<int N>
+multiDouble<N> parseMultiDouble(const std::string& input);
+
+template<int N>
+multiDouble<N> abs(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> sqrt(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> exp(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> log(const multiDouble<N>& a);
+
+/// @brief sin and cos of the same value, cheaper than doing both on their own
+template<int N>
+void sincos(const multiDouble<N>& a, multiDouble<N>& s, multiDouble<N>& c);
+
+template<int N>
+multiDouble<N> sin(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> cos(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> sinh(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> cosh(const multiDouble<N>& a);
+
+template<int N>
+multiDouble<N> atan2(const multiDouble<N>& y, const multiDouble<N>& x);
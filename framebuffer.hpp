@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <numeric>
+#include <type_traits>
+
+/// @brief rows of a rectangle in a framebuffer, or of a whole one. Doesn't own the memory
+template<typename T>
+struct framebufferView {
+    T* data;
+    int width;
+    int height;
+    //elements from the start of one row to the start of the next
+    std::ptrdiff_t stride;
+
+    T& operator () (int column, int row) const {
+        return data[row * stride + column];
+    }
+
+    T* row(int row) const {
+        return data + row * stride;
+    }
+};
+
+/// @brief one value for every pixel of an image in a single allocation, a row at a time in the same order that
+/// images are written in. Each row starts on a new cache line so rows can be worked on by different threads
+template<typename T>
+class framebuffer {
+    //values are copied and filled without constructors
+    static_assert(std::is_trivially_copyable<T>::value, "framebuffer values have to be trivially copyable");
+public:
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    framebuffer() = default;
+
+    /// @brief the values are left unset so they can be filled by whichever thread will use them, see fillRows
+    framebuffer(int width, int height) : w(width), h(height) {
+        //the smallest number of values that is a whole number of cache lines
+        std::size_t line = ALIGNMENT / std::gcd(sizeof(T), ALIGNMENT);
+        s = (std::ptrdiff_t(width) + line - 1) / line * line;
+        allocate();
+    }
+
+    framebuffer(int width, int height, const T& value) : framebuffer(width, height) {
+        fillRows(0, height, value);
+    }
+
+    framebuffer(const framebuffer& other) : w(other.w), h(other.h), s(other.s) {
+        allocate();
+        std::copy(other.values, other.values + s * h, values);
+    }
+
+    framebuffer(framebuffer&& other) noexcept : w(other.w), h(other.h), s(other.s), values(other.values) {
+        other.values = nullptr;
+        other.w = other.h = 0;
+        other.s = 0;
+    }
+
+    framebuffer& operator = (framebuffer other) noexcept {
+        std::swap(w, other.w);
+        std::swap(h, other.h);
+        std::swap(s, other.s);
+        std::swap(values, other.values);
+        return *this;
+    }
+
+    ~framebuffer() {
+        if (values != nullptr)
+            ::operator delete(values, std::align_val_t(ALIGNMENT));
+    }
+
+    int width() const { return w; }
+    int height() const { return h; }
+    std::ptrdiff_t stride() const { return s; }
+
+    T& operator () (int column, int row) {
+        return values[row * s + column];
+    }
+
+    const T& operator () (int column, int row) const {
+        return values[row * s + column];
+    }
+
+    T* row(int row) {
+        return values + row * s;
+    }
+
+    const T* row(int row) const {
+        return values + row * s;
+    }
+
+    /// @brief set every value of rows first up to but not including last
+    void fillRows(int first, int last, const T& value) {
+        for (int j = first; j < last; j++)
+            std::fill(row(j), row(j) + w, value);
+    }
+
+    framebufferView<T> view() {
+        return { values, w, h, s };
+    }
+
+    framebufferView<const T> view() const {
+        return { values, w, h, s };
+    }
+
+    /// @brief a rectangle of the framebuffer, indexed from its top left corner
+    framebufferView<T> view(int left, int top, int width, int height) {
+        return { values + top * s + left, width, height, s };
+    }
+
+    framebufferView<const T> view(int left, int top, int width, int height) const {
+        return { values + top * s + left, width, height, s };
+    }
+
+private:
+    void allocate() {
+        values = s * h > 0 ? static_cast<T*>(::operator new(sizeof(T) * s * h, std::align_val_t(ALIGNMENT))) : nullptr;
+    }
+
+    int w = 0;
+    int h = 0;
+    std::ptrdiff_t s = 0;
+    T* values = nullptr;
+};
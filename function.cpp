@@ -2,7 +2,8 @@
 
 /// @brief init function object
 /// @param funcString function string
-void func::init(std::string funcString) {
+/// @param verbose print how the function was interpreted
+void func::init(std::string funcString, bool verbose) {
     function_string = funcString;
 
     //remove all spaces
@@ -19,7 +20,9 @@ void func::init(std::string funcString) {
         pre_format();
         parse_tokens(tokens);
         while(simplify());
-        std::cout << "Interpreted as: " << get_tokens() << std::endl;
+        compile();
+        if (verbose)
+            std::cout << "Interpreted as: " << get_tokens() << std::endl;
     }
     catch (int exc) {
         std::cout << "Error parsing function. ";
@@ -36,9 +39,6 @@ void func::init(std::string funcString) {
         case 4:
             std::cout << "This is most likely an unknown charecter" << std::endl;
             break;
-        case 5:
-            std::cout << "Can't do powers" << std::endl;
-            break;
         default:
             std::cout << "Assert error on line number " << exc << "in file " << __FILE__ <<std::endl;
         }
@@ -50,6 +50,8 @@ void func::init(std::string funcString) {
 void func::init() {
     while (true) {
         tokens.clear();
+        stack.clear();
+        number_stack.clear();
         std::cout << "Enter a function: ";
         std::cin >> function_string;
         if (std::cin.fail()){
@@ -71,6 +73,7 @@ void func::init() {
             pre_format();
             parse_tokens(tokens);
             while(simplify());
+            compile();
             std::cout << "Interpreted as: " << get_tokens() << std::endl;
             break;
         }
@@ -88,9 +91,6 @@ void func::init() {
             case 4:
                 std::cout << "Error when trying to parse function, this is most likely an unknown character" << std::endl;
                 break;
-            case 5:
-                std::cout << "Can't do powers yet lol" << std::endl;
-                break;
             default:
                 std::cout << "Assert error on line number " << exc << std::endl;
             }
@@ -2,7 +2,14 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <map>
+#include <tuple>
 #include "complex.hpp"
+#include "dual.hpp"
+#include "batch.hpp"
+#include "taylor.hpp"
+#include "extended.hpp"
+#include "polynomial.hpp"
 
 #ifdef __DEBUG
 #define assert(expr) if(!expr) std::cout << "Assert error on line " << __LINE__ << " in file " << __FILE__ << std::endl; throw __LINE__
@@ -27,7 +34,29 @@ enum {
     SEC = 12,
     CSC = 13,
     COT = 14,
-    LN = 15
+    LN = 15,
+
+    //only used in compiled programs
+    SQUARE = 16,
+    SINCOS = 17,
+    RECIPROCAL = 18,
+    POWI = 19
+};
+
+/// @brief largest integer power that is turned into repeated squaring instead of exp(b*ln(a))
+constexpr auto MAX_INTEGER_POWER = 1024;
+
+/// @brief native code that does one newton step in place on BATCH_SIZE points, see jit.hpp
+typedef void (*newtonKernel)(double* re, double* im);
+
+/// @brief one step of a compiled function, computes registers[dst] = op(registers[a], registers[b])
+/// SINCOS has two outputs, the sine is written to registers[dst] and the cosine to registers[b]
+/// POWI raises registers[a] to the power b, b is the exponent itself and not a register
+struct instruction {
+    unsigned short op;
+    unsigned short dst;
+    unsigned short a;
+    unsigned short b;
 };
 
 class func
@@ -37,7 +66,7 @@ public:
 
     }
 
-    void init(std::string funcString);
+    void init(std::string funcString, bool verbose = true);
 
     void init();
 
@@ -46,6 +75,32 @@ public:
     std::vector<complex> number_stack;
     std::vector<unsigned short> stack;
 
+    //compiled form of stack, see compile()
+    std::vector<instruction> program;
+    std::vector<complex> registers;
+    std::vector<dual> dualRegisters;
+    //registers for evaluate_batch, one set for each precision
+    std::vector<dualBatch> batchRegisters;
+    std::vector<basicDualBatch<float>> floatBatchRegisters;
+    std::vector<basicDualBatch<doubleDouble>> doubleDoubleBatchRegisters;
+    std::vector<basicDualBatch<quadDouble>> quadDoubleBatchRegisters;
+    //registers for evaluate_taylor, one set for each precision
+    std::vector<basicTaylorBatch<double>> taylorRegisters;
+    std::vector<basicTaylorBatch<float>> floatTaylorRegisters;
+    std::vector<basicTaylorBatch<doubleDouble>> doubleDoubleTaylorRegisters;
+    std::vector<basicTaylorBatch<quadDouble>> quadDoubleTaylorRegisters;
+    unsigned short result = 0;
+
+    //if set, used instead of the interpreter for newton steps on batches
+    newtonKernel kernel = nullptr;
+
+    //if the function is a polynomial or a ratio of polynomials it is also stored as numerator/denominator,
+    //with every root of the function and a radius around each root where newtons method is known to converge to it
+    bool rational = false;
+    polynomial numerator, denominator;
+    std::vector<complex> roots;
+    std::vector<double> attractionRadius;
+
     /// @return String that represents the function after being converted to RPN
     std::string RPN() {
         std::string output = "";
@@ -101,6 +156,15 @@ public:
         return output;
     }
 
+    /// @return weather two functions have the same RPN, including the exact value of every number
+    bool matches(func& other) {
+        if (stack != other.stack) return false;
+        for (int i = 0; i < stack.size(); i++) {
+            if (stack[i] == NUMBER && !(number_stack[i] == other.number_stack[i])) return false;
+        }
+        return true;
+    }
+
     /// @return function in infix notation
     std::string get_tokens() {
         std::string output = "";
@@ -118,9 +182,357 @@ public:
         return output;
     }
 
+    /// @brief Turn the RPN stack into a flat program. Register 0 holds the variable, constants are
+    /// loaded into registers once here and every instruction writes to its own register.
+    /// Repeated subexpressions and constants share a register, sin/cos/tan/sec/csc/cot of the same
+    /// argument share one SINCOS and x*x becomes SQUARE
+    void compile() {
+        std::vector<unsigned short> operands;
+        std::map<std::tuple<unsigned short, unsigned short, unsigned short>, unsigned short> known;
+        std::map<unsigned short, std::pair<unsigned short, unsigned short>> sincosOf;
+        std::map<complex, unsigned short> constants;
+        program.clear();
+        registers.assign(1, complex(0));
+        for (int i = 0; i < stack.size(); i++) {
+            switch (stack[i])
+            {
+            case NUMBER:
+                operands.push_back(constant(constants, number_stack[i]));
+                break;
+            case VARIABLE:
+                operands.push_back(0);
+                break;
+            case SIN:
+            case COS:
+            case TAN:
+            case SEC:
+            case CSC:
+            case COT:
+            {
+                if (operands.size() < 1) throw __LINE__;
+                unsigned short a = operands.back();
+                operands.pop_back();
+                if (sincosOf.count(a) == 0) {
+                    instruction step;
+                    step.op = SINCOS;
+                    step.a = a;
+                    step.dst = registers.size();
+                    step.b = registers.size() + 1;
+                    registers.push_back(0);
+                    registers.push_back(0);
+                    program.push_back(step);
+                    sincosOf[a] = std::make_pair(step.dst, step.b);
+                }
+                unsigned short s = sincosOf[a].first;
+                unsigned short c = sincosOf[a].second;
+                switch (stack[i])
+                {
+                case SIN:
+                    operands.push_back(s);
+                    break;
+                case COS:
+                    operands.push_back(c);
+                    break;
+                case TAN:
+                    operands.push_back(emit(known, DIVIDE, s, c));
+                    break;
+                case SEC:
+                    operands.push_back(emit(known, RECIPROCAL, c, 0));
+                    break;
+                case CSC:
+                    operands.push_back(emit(known, RECIPROCAL, s, 0));
+                    break;
+                case COT:
+                    operands.push_back(emit(known, DIVIDE, c, s));
+                    break;
+                }
+                break;
+            }
+            case LN:
+            {
+                if (operands.size() < 1) throw __LINE__;
+                unsigned short a = operands.back();
+                operands.pop_back();
+                operands.push_back(emit(known, LN, a, 0));
+                break;
+            }
+            default:
+            {
+                if (operands.size() < 2) throw __LINE__;
+                unsigned short b = operands.back();
+                operands.pop_back();
+                unsigned short a = operands.back();
+                operands.pop_back();
+                int exponent;
+                if (stack[i] == POWER && integer_constant(b, exponent)) {
+                    operands.push_back(integer_power(known, constants, a, exponent));
+                    break;
+                }
+                if (stack[i] == MULTIPLY && a == b) {
+                    operands.push_back(emit(known, SQUARE, a, 0));
+                    break;
+                }
+                //a + b and a * b are the same instruction as b + a and b * a
+                if ((stack[i] == ADD || stack[i] == MULTIPLY) && b < a) {
+                    std::swap(a, b);
+                }
+                operands.push_back(emit(known, stack[i], a, b));
+                break;
+            }
+            }
+        }
+        if (operands.size() != 1) throw __LINE__;
+        result = operands.back();
+
+        //constants have a derivative of 0 and the variable has a derivative of 1
+        dualRegisters.assign(registers.size(), dual());
+        for (int i = 0; i < registers.size(); i++) {
+            dualRegisters[i].value = registers[i];
+        }
+        dualRegisters[0].derivative = 1;
+
+        load_batch_registers<double>();
+        load_batch_registers<float>();
+        load_batch_registers<doubleDouble>();
+        load_batch_registers<quadDouble>();
+        load_taylor_registers<double>();
+        load_taylor_registers<float>();
+        load_taylor_registers<doubleDouble>();
+        load_taylor_registers<quadDouble>();
+
+        find_rational_form();
+    }
+
+    /// @return index of the known root closest to a value, or -1 if there are no known roots
+    /// @param distance set to the distance to that root
+    int nearest_root(complex value, double& distance) {
+        int nearest = -1;
+        double distanceSquared = INFINITY;
+        for (int i = 0; i < roots.size(); i++) {
+            double re = value.re - roots[i].re;
+            double im = value.im - roots[i].im;
+            if ((re * re) + (im * im) < distanceSquared) {
+                distanceSquared = (re * re) + (im * im);
+                nearest = i;
+            }
+        }
+        distance = sqrt(distanceSquared);
+        return nearest;
+    }
+
     /// @brief evaluates the function
     complex evaluate_function(complex input) {
-        return evaluateRPN(stack.size() - 1, input);
+        registers[0] = input;
+        for (const instruction& step : program) {
+            complex& a = registers[step.a];
+            switch (step.op)
+            {
+            case ADD:
+                registers[step.dst] = a + registers[step.b];
+                break;
+            case SUBTRACT:
+                registers[step.dst] = a - registers[step.b];
+                break;
+            case MULTIPLY:
+                registers[step.dst] = a * registers[step.b];
+                break;
+            case DIVIDE:
+                registers[step.dst] = a / registers[step.b];
+                break;
+            case SQUARE:
+                registers[step.dst] = square(a);
+                break;
+            case RECIPROCAL:
+                registers[step.dst] = 1 / a;
+                break;
+            case SINCOS:
+                sincos(a, registers[step.dst], registers[step.b]);
+                break;
+            case LN:
+                registers[step.dst] = log(a);
+                break;
+            case POWI:
+                registers[step.dst] = powi(a, step.b);
+                break;
+            case POWER:
+                registers[step.dst] = pow(a, registers[step.b]);
+                break;
+            default:
+                throw 5;
+            }
+        }
+        return registers[result];
+    }
+
+    /// @brief evaluates the function and its derivative in one pass
+    dual evaluate_dual(complex input) {
+        dualRegisters[0].value = input;
+        for (const instruction& step : program) {
+            dual& a = dualRegisters[step.a];
+            switch (step.op)
+            {
+            case ADD:
+                dualRegisters[step.dst] = a + dualRegisters[step.b];
+                break;
+            case SUBTRACT:
+                dualRegisters[step.dst] = a - dualRegisters[step.b];
+                break;
+            case MULTIPLY:
+                dualRegisters[step.dst] = a * dualRegisters[step.b];
+                break;
+            case DIVIDE:
+                dualRegisters[step.dst] = a / dualRegisters[step.b];
+                break;
+            case SQUARE:
+                dualRegisters[step.dst] = square(a);
+                break;
+            case RECIPROCAL:
+                dualRegisters[step.dst] = 1 / a;
+                break;
+            case SINCOS:
+                sincos(a, dualRegisters[step.dst], dualRegisters[step.b]);
+                break;
+            case LN:
+                dualRegisters[step.dst] = log(a);
+                break;
+            case POWI:
+                dualRegisters[step.dst] = powi(a, step.b);
+                break;
+            case POWER:
+                dualRegisters[step.dst] = pow(a, dualRegisters[step.b]);
+                break;
+            default:
+                throw 5;
+            }
+        }
+        return dualRegisters[result];
+    }
+
+    /// @brief evaluates the function and its derivative for batchSize<T> points at once, in float or double
+    /// @return reference to the register holding the result, valid until the next evaluation
+    template<typename T>
+    const basicDualBatch<T>& evaluate_batch(const basicComplexBatch<T>& input) {
+        std::vector<basicDualBatch<T>>& batchRegisters = batch_registers<T>();
+        batchRegisters[0].value = input;
+        for (const instruction& step : program) {
+            basicDualBatch<T>& a = batchRegisters[step.a];
+            switch (step.op)
+            {
+            case ADD:
+                add(batchRegisters[step.dst], a, batchRegisters[step.b]);
+                break;
+            case SUBTRACT:
+                subtract(batchRegisters[step.dst], a, batchRegisters[step.b]);
+                break;
+            case MULTIPLY:
+                multiply(batchRegisters[step.dst], a, batchRegisters[step.b]);
+                break;
+            case DIVIDE:
+                divide(batchRegisters[step.dst], a, batchRegisters[step.b]);
+                break;
+            case SQUARE:
+                square(batchRegisters[step.dst], a);
+                break;
+            case RECIPROCAL:
+                reciprocal(batchRegisters[step.dst], a);
+                break;
+            case SINCOS:
+                sincos(batchRegisters[step.dst], batchRegisters[step.b], a);
+                break;
+            case LN:
+                log(batchRegisters[step.dst], a);
+                break;
+            case POWI:
+                powi(batchRegisters[step.dst], a, step.b);
+                break;
+            case POWER:
+                pow(batchRegisters[step.dst], a, batchRegisters[step.b]);
+                break;
+            default:
+                throw 5;
+            }
+        }
+        return batchRegisters[result];
+    }
+
+    /// @brief Evaluate the first terms of the taylor series of the function around every lane of a batch, for
+    /// iteration methods that need more than the first derivative. Works the same way as evaluate_batch
+    /// @param input values of x for each lane
+    /// @param terms number of terms to work out, at most MAX_TAYLOR_TERMS
+    /// @return reference to the register holding the result, valid until the next call
+    template<typename T>
+    const basicTaylorBatch<T>& evaluate_taylor(const basicComplexBatch<T>& input, int terms) {
+        std::vector<basicTaylorBatch<T>>& taylorRegisters = taylor_registers<T>();
+        taylorRegisters[0].term[0] = input;
+        for (const instruction& step : program) {
+            basicTaylorBatch<T>& a = taylorRegisters[step.a];
+            switch (step.op)
+            {
+            case ADD:
+                add(taylorRegisters[step.dst], a, taylorRegisters[step.b], terms);
+                break;
+            case SUBTRACT:
+                subtract(taylorRegisters[step.dst], a, taylorRegisters[step.b], terms);
+                break;
+            case MULTIPLY:
+                multiply(taylorRegisters[step.dst], a, taylorRegisters[step.b], terms);
+                break;
+            case DIVIDE:
+                divide(taylorRegisters[step.dst], a, taylorRegisters[step.b], terms);
+                break;
+            case SQUARE:
+                square(taylorRegisters[step.dst], a, terms);
+                break;
+            case RECIPROCAL:
+                reciprocal(taylorRegisters[step.dst], a, terms);
+                break;
+            case SINCOS:
+                sincos(taylorRegisters[step.dst], taylorRegisters[step.b], a, terms);
+                break;
+            case LN:
+                log(taylorRegisters[step.dst], a, terms);
+                break;
+            case POWI:
+                powi(taylorRegisters[step.dst], a, step.b, terms);
+                break;
+            case POWER:
+                pow(taylorRegisters[step.dst], a, taylorRegisters[step.b], terms);
+                break;
+            default:
+                throw 5;
+            }
+        }
+        return taylorRegisters[result];
+    }
+
+    /// @return the registers evaluate_batch uses for batches of T
+    template<typename T>
+    std::vector<basicDualBatch<T>>& batch_registers();
+
+    /// @return the registers evaluate_taylor uses for batches of T
+    template<typename T>
+    std::vector<basicTaylorBatch<T>>& taylor_registers();
+
+    /// @brief copies every register into every lane of the batch registers for T
+    template<typename T>
+    void load_batch_registers() {
+        std::vector<basicDualBatch<T>>& batchRegisters = batch_registers<T>();
+        batchRegisters.resize(registers.size());
+        for (int i = 0; i < registers.size(); i++) {
+            broadcast(batchRegisters[i], registers[i].re, registers[i].im, 0, 0);
+        }
+        broadcast(batchRegisters[0], 0, 0, 1, 0);
+    }
+
+    /// @brief copies every register into every lane of the taylor registers for T, constants have no other terms
+    template<typename T>
+    void load_taylor_registers() {
+        std::vector<basicTaylorBatch<T>>& taylorRegisters = taylor_registers<T>();
+        taylorRegisters.resize(registers.size());
+        for (int i = 0; i < registers.size(); i++) {
+            broadcast(taylorRegisters[i], registers[i].re, registers[i].im, 0, 0, MAX_TAYLOR_TERMS);
+        }
+        broadcast(taylorRegisters[0], 0, 0, 1, 0, MAX_TAYLOR_TERMS);
     }
 
 private:
@@ -241,7 +653,6 @@ private:
             }
             else if (input[0] == '^') {
                 //power operator
-                throw 5;
                 tokens.push_back("^");
                 input.erase(0, 1);
             }
@@ -444,12 +855,260 @@ private:
         return func;
     }
 
-    //TODO:
-    //Make complicated funtions less complicated
+    /// @return how many values an operator in the RPN stack takes
+    int arity(unsigned short op) {
+        if (op == NUMBER || op == VARIABLE) return 0;
+        if (op >= SIN) return 1;
+        return 2;
+    }
+
+    /// @brief Find where the subexpression that ends at a point in the RPN stack starts
+    /// @param end index of the last item (the operator) of the subexpression
+    int subexpression_start(int end) {
+        int needed = 1;
+        while (true) {
+            needed += arity(stack[end]) - 1;
+            if (needed == 0) return end;
+            end--;
+        }
+    }
+
+    /// @brief apply an operator to constant values, used to fold constants before compiling
+    complex apply(unsigned short op, complex a, complex b) {
+        switch (op)
+        {
+        case ADD:
+            return a + b;
+        case SUBTRACT:
+            return a - b;
+        case MULTIPLY:
+            return a * b;
+        case DIVIDE:
+            return a / b;
+        case SIN:
+            return sin(a);
+        case COS:
+            return cos(a);
+        case TAN:
+            return tan(a);
+        case SEC:
+            return sec(a);
+        case CSC:
+            return csc(a);
+        case COT:
+            return cot(a);
+        case LN:
+            return log(a);
+        case POWER:
+            return pow(a, b);
+        default:
+            throw 5;
+        }
+    }
+
+    /// @brief Replace part of the RPN stack with a single number
+    void replace_with_number(int start, int end, complex value) {
+        stack.erase(stack.begin() + start + 1, stack.begin() + end + 1);
+        number_stack.erase(number_stack.begin() + start + 1, number_stack.begin() + end + 1);
+        stack[start] = NUMBER;
+        number_stack[start] = value;
+    }
+
+    /// @brief Remove part of the RPN stack
+    void remove(int start, int end) {
+        stack.erase(stack.begin() + start, stack.begin() + end + 1);
+        number_stack.erase(number_stack.begin() + start, number_stack.begin() + end + 1);
+    }
+
+    /// @brief Make complicated funtions less complicated by folding constant subexpressions
+    /// and removing operations that do nothing (x*1, x/1, x^1, x+0, x-0, 1*x, 0+x)
+    /// @return weather anything was changed, call until it returns false
     bool simplify() {
+        for (int i = 0; i < stack.size(); i++) {
+            if (arity(stack[i]) == 1 && stack[i - 1] == NUMBER) {
+                replace_with_number(i - 1, i, apply(stack[i], number_stack[i - 1], 0));
+                return true;
+            }
+            if (arity(stack[i]) != 2) continue;
+
+            int right = subexpression_start(i - 1);
+            int left = subexpression_start(right - 1);
+            bool rightNumber = right == i - 1 && stack[right] == NUMBER;
+            bool leftNumber = left == right - 1 && stack[left] == NUMBER;
+            if (leftNumber && rightNumber) {
+                replace_with_number(left, i, apply(stack[i], number_stack[left], number_stack[right]));
+                return true;
+            }
+            if (rightNumber) {
+                bool one = number_stack[right] == complex(1);
+                bool zero = number_stack[right] == complex(0);
+                if (((stack[i] == MULTIPLY || stack[i] == DIVIDE || stack[i] == POWER) && one) || ((stack[i] == ADD || stack[i] == SUBTRACT) && zero)) {
+                    remove(right, i);
+                    return true;
+                }
+            }
+            if (leftNumber) {
+                bool one = number_stack[left] == complex(1);
+                bool zero = number_stack[left] == complex(0);
+                if ((stack[i] == MULTIPLY && one) || (stack[i] == ADD && zero)) {
+                    remove(i, i);
+                    remove(left, left);
+                    return true;
+                }
+            }
+        }
         return false;
     }
 
+    /// @brief If the function only uses + - * / on numbers and x, store it as a ratio of polynomials and find its roots
+    void find_rational_form() {
+        rational = false;
+        roots.clear();
+        attractionRadius.clear();
+        std::vector<polynomial> numerators, denominators;
+        for (int i = 0; i < stack.size(); i++) {
+            switch (stack[i])
+            {
+            case NUMBER:
+                numerators.push_back(polynomial(number_stack[i]));
+                denominators.push_back(polynomial(1));
+                break;
+            case VARIABLE:
+            {
+                polynomial x(0);
+                x.coefficients.push_back(1);
+                numerators.push_back(x);
+                denominators.push_back(polynomial(1));
+                break;
+            }
+            case ADD:
+            case SUBTRACT:
+            case MULTIPLY:
+            case DIVIDE:
+            {
+                polynomial bn = numerators.back(), bd = denominators.back();
+                numerators.pop_back();
+                denominators.pop_back();
+                polynomial an = numerators.back(), ad = denominators.back();
+                numerators.pop_back();
+                denominators.pop_back();
+                bool sameDenominator = ad.coefficients == bd.coefficients;
+                if (stack[i] == ADD) {
+                    numerators.push_back(sameDenominator ? an + bn : an * bd + bn * ad);
+                    denominators.push_back(sameDenominator ? ad : ad * bd);
+                }
+                else if (stack[i] == SUBTRACT) {
+                    numerators.push_back(sameDenominator ? an - bn : an * bd - bn * ad);
+                    denominators.push_back(sameDenominator ? ad : ad * bd);
+                }
+                else if (stack[i] == MULTIPLY) {
+                    numerators.push_back(an * bn);
+                    denominators.push_back(ad * bd);
+                }
+                else {
+                    numerators.push_back(an * bd);
+                    denominators.push_back(ad * bn);
+                }
+                if (numerators.back().degree() > MAX_POLYNOMIAL_DEGREE || denominators.back().degree() > MAX_POLYNOMIAL_DEGREE) return;
+                break;
+            }
+            case POWER:
+            {
+                //only integer powers keep it a ratio of polynomials
+                polynomial bn = numerators.back(), bd = denominators.back();
+                numerators.pop_back();
+                denominators.pop_back();
+                if (bn.degree() != 0 || bd.degree() != 0) return;
+                complex exponent = bn.coefficients[0] / bd.coefficients[0];
+                if (exponent.im != 0 || exponent.re != round(exponent.re)) return;
+                int n = std::abs(int(exponent.re));
+                if (std::abs(exponent.re) > MAX_POLYNOMIAL_DEGREE) return;
+                if (std::max(numerators.back().degree(), denominators.back().degree()) * n > MAX_POLYNOMIAL_DEGREE) return;
+                polynomial an(1), ad(1);
+                for (int k = 0; k < n; k++) {
+                    an = an * numerators.back();
+                    ad = ad * denominators.back();
+                }
+                numerators.back() = exponent.re < 0 ? ad : an;
+                denominators.back() = exponent.re < 0 ? an : ad;
+                break;
+            }
+            default:
+                return;
+            }
+        }
+        if (numerators.size() != 1 || numerators[0].degree() < 1) return;
+        numerator = numerators[0];
+        denominator = denominators[0];
+        rational = true;
+
+        //roots of the numerator that are also roots of the denominator are not roots of the function
+        for (complex root : ::roots(numerator)) {
+            if (denominator.evaluate(root).size() > 1e-9 * (1 + root.size())) roots.push_back(root);
+        }
+
+        //For a polynomial of degree n with simple roots, a newton step from a point closer to root i than
+        //D/(2n-1) (D = distance to the nearest other root) always lands closer to root i. Half of that
+        //is used to leave room for error in the computed roots. Rational functions don't get a radius
+        int n = numerator.degree();
+        for (int i = 0; i < roots.size(); i++) {
+            double separation = INFINITY;
+            for (int j = 0; j < roots.size(); j++) {
+                if (j != i) separation = std::min(separation, (roots[i] - roots[j]).size());
+            }
+            if (denominator.degree() > 0 || separation < 1e-6) attractionRadius.push_back(0);
+            else attractionRadius.push_back(0.5 * separation / (2 * n - 1));
+        }
+    }
+
+    /// @return register holding a constant, shared with any other use of the same constant
+    unsigned short constant(std::map<complex, unsigned short>& constants, complex value) {
+        auto found = constants.find(value);
+        if (found != constants.end()) return found->second;
+        registers.push_back(value);
+        constants[value] = registers.size() - 1;
+        return registers.size() - 1;
+    }
+
+    /// @return weather a register is a constant that is a small integer
+    /// @param exponent set to the integer
+    bool integer_constant(unsigned short reg, int& exponent) {
+        for (const instruction& step : program) {
+            if (step.dst == reg || (step.op == SINCOS && step.b == reg)) return false;
+        }
+        if (reg == 0 || registers[reg].im != 0 || registers[reg].re != round(registers[reg].re)) return false;
+        if (std::abs(registers[reg].re) > MAX_INTEGER_POWER) return false;
+        exponent = int(registers[reg].re);
+        return true;
+    }
+
+    /// @brief emit a^n for an integer n. x^2 is SQUARE, negative powers take the reciprocal of the positive power
+    /// @return register holding the result
+    unsigned short integer_power(std::map<std::tuple<unsigned short, unsigned short, unsigned short>, unsigned short>& known, std::map<complex, unsigned short>& constants, unsigned short a, int n) {
+        if (n == 0) return constant(constants, 1);
+        if (n < 0) return emit(known, RECIPROCAL, integer_power(known, constants, a, -n), 0);
+        if (n == 1) return a;
+        if (n == 2) return emit(known, SQUARE, a, 0);
+        return emit(known, POWI, a, n);
+    }
+
+    /// @brief add an instruction to the program unless the same instruction already exists
+    /// @return register holding the result
+    unsigned short emit(std::map<std::tuple<unsigned short, unsigned short, unsigned short>, unsigned short>& known, unsigned short op, unsigned short a, unsigned short b) {
+        auto key = std::make_tuple(op, a, b);
+        auto found = known.find(key);
+        if (found != known.end()) return found->second;
+        instruction step;
+        step.op = op;
+        step.dst = registers.size();
+        step.a = a;
+        step.b = b;
+        registers.push_back(0);
+        program.push_back(step);
+        known[key] = step.dst;
+        return step.dst;
+    }
+
     /// @brief Change a vector of tokens to RPN using the shunting yard algoritm
     void parse_tokens(std::vector<std::string> tokens) {
         std::vector<unsigned short> operator_stack;
@@ -482,6 +1141,10 @@ private:
                     if (type(tokens[0]) > operator_stack.back()) {
                         break;
                     }
+                    //powers are right associative, x^2^3 is x^(2^3)
+                    if (type(tokens[0]) == POWER && operator_stack.back() == POWER) {
+                        break;
+                    }
                     stack.push_back(operator_stack.back());
                     number_stack.push_back(0);
                     operator_stack.pop_back();
@@ -530,79 +1193,44 @@ private:
             operator_stack.pop_back();
         }
     }
-    
-    /// @brief Evalute a function in RPN using a recursive algorithm
-    /// @param startPoint point to start at in the function
-    /// @param input value to replace all of the variables with
-    /// @return output of the function
-    complex evaluateRPN(int startPoint, complex input) {
-        if (stack[startPoint] == NUMBER) return number_stack[startPoint];
-        if (stack[startPoint] == VARIABLE) return input;
-
-        complex num1 = evaluateRPN(startPoint - 1, input);
-
-        if (stack[startPoint] >= SIN) {
-            switch (stack[startPoint])
-            {
-            case SIN:
-                return sin(num1);
-                break;
-            case COS:
-                return cos(num1);
-                break;
-            case TAN:
-                return tan(num1);
-                break;
-            case SEC:
-                return sec(num1);
-                break;
-            case CSC:
-                return csc(num1);
-                break;
-            case COT:
-                return cot(num1);
-                break;
-            case LN:
-                return log(num1);
-                break;
-            }
-        }
-        int startPoint2 = startPoint - 2;
-        int i = 0;
+};
 
-        if (stack[startPoint - 1] >= SIN) i += 1;
-        else if (stack[startPoint - 1] >= ADD) i += 2;
+template<>
+inline std::vector<basicDualBatch<double>>& func::batch_registers<double>() {
+    return batchRegisters;
+}
 
-        while (i > 0) {
-            if (stack[startPoint2] >= SIN) i += 1;
-            else if (stack[startPoint2] >= ADD) i += 2;
-            startPoint2--;
-            i--;
-        }
+template<>
+inline std::vector<basicDualBatch<float>>& func::batch_registers<float>() {
+    return floatBatchRegisters;
+}
 
-        complex num2 = evaluateRPN(startPoint2, input);
+template<>
+inline std::vector<basicDualBatch<doubleDouble>>& func::batch_registers<doubleDouble>() {
+    return doubleDoubleBatchRegisters;
+}
 
-        switch (stack[startPoint])
-        {
-        case POWER:
-            throw 3;
+template<>
+inline std::vector<basicDualBatch<quadDouble>>& func::batch_registers<quadDouble>() {
+    return quadDoubleBatchRegisters;
+}
 
-            //return pow(num, num2);
-            break;
-        case MULTIPLY:
-            return num2 * num1;
-            break;
-        case DIVIDE:
-            return num2 / num1;
-            break;
-        case ADD:
-            return num2 + num1;
-            break;
-        case SUBTRACT:
-            return num2 - num1;
-            break;
-        default:
-            throw 5;
-        }
-    }
-};
\ No newline at end of file
+template<>
+inline std::vector<basicTaylorBatch<double>>& func::taylor_registers<double>() {
+    return taylorRegisters;
+}
+
+template<>
+inline std::vector<basicTaylorBatch<float>>& func::taylor_registers<float>() {
+    return floatTaylorRegisters;
+}
+
+template<>
+inline std::vector<basicTaylorBatch<doubleDouble>>& func::taylor_registers<doubleDouble>() {
+    return doubleDoubleTaylorRegisters;
+}
+
+template<>
+inline std::vector<basicTaylorBatch<quadDouble>>& func::taylor_registers<quadDouble>() {
+    return quadDoubleTaylorRegisters;
+}
@@ -0,0 +1,268 @@
+#include "jit.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+//bump when the generated code changes so old cached kernels are not used
+constexpr auto KERNEL_VERSION = 2;
+
+/// @brief exact text for a double so constants are not rounded in the generated code
+std::string literal(double v) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", v);
+    return buffer;
+}
+
+/// @brief names of the value and derivative variables for a register
+std::string vr(int reg) { return "v" + std::to_string(reg) + "r"; }
+std::string vi(int reg) { return "v" + std::to_string(reg) + "i"; }
+std::string dr(int reg) { return "d" + std::to_string(reg) + "r"; }
+std::string di(int reg) { return "d" + std::to_string(reg) + "i"; }
+
+std::string kernel_source(func& function) {
+    std::ostringstream src;
+    src << "//generated from: " << function.RPN() << "\n";
+    src << "#include <cmath>\n";
+    src << "extern \"C\" void newton_step(double* re, double* im) {\n";
+    src << "    for (int lane = 0; lane < " << BATCH_SIZE << "; lane++) {\n";
+    src << "        const double v0r = re[lane], v0i = im[lane], d0r = 1, d0i = 0;\n";
+
+    //constants are every register that no instruction writes to
+    std::vector<bool> written(function.registers.size(), false);
+    for (const instruction& step : function.program) {
+        written[step.dst] = true;
+        if (step.op == SINCOS) written[step.b] = true;
+    }
+    for (int i = 1; i < function.registers.size(); i++) {
+        if (written[i]) continue;
+        src << "        const double " << vr(i) << " = " << literal(function.registers[i].re) << ", " << vi(i) << " = " << literal(function.registers[i].im)
+            << ", " << dr(i) << " = 0, " << di(i) << " = 0;\n";
+    }
+
+    for (int i = 1; i < function.registers.size(); i++) {
+        if (!written[i]) continue;
+        src << "        double " << vr(i) << ", " << vi(i) << ", " << dr(i) << ", " << di(i) << ";\n";
+    }
+
+    //same formulas as batch.cpp, with the registers turned into local variables
+    for (const instruction& step : function.program) {
+        int o = step.dst, a = step.a, b = step.b;
+        src << "        {\n";
+        switch (step.op)
+        {
+        case ADD:
+        case SUBTRACT:
+        {
+            const char* sign = step.op == ADD ? " + " : " - ";
+            src << "            " << vr(o) << " = " << vr(a) << sign << vr(b) << "; " << vi(o) << " = " << vi(a) << sign << vi(b) << ";\n";
+            src << "            " << dr(o) << " = " << dr(a) << sign << dr(b) << "; " << di(o) << " = " << di(a) << sign << di(b) << ";\n";
+            break;
+        }
+        case MULTIPLY:
+            src << "            " << vr(o) << " = (" << vr(a) << " * " << vr(b) << ") - (" << vi(a) << " * " << vi(b) << ");\n";
+            src << "            " << vi(o) << " = (" << vi(a) << " * " << vr(b) << ") + (" << vr(a) << " * " << vi(b) << ");\n";
+            src << "            " << dr(o) << " = ((" << dr(a) << " * " << vr(b) << ") - (" << di(a) << " * " << vi(b) << ")) + ((" << vr(a) << " * " << dr(b) << ") - (" << vi(a) << " * " << di(b) << "));\n";
+            src << "            " << di(o) << " = ((" << di(a) << " * " << vr(b) << ") + (" << dr(a) << " * " << vi(b) << ")) + ((" << vi(a) << " * " << dr(b) << ") + (" << vr(a) << " * " << di(b) << "));\n";
+            break;
+        case DIVIDE:
+            src << "            const double c = 1 / ((" << vr(b) << " * " << vr(b) << ") + (" << vi(b) << " * " << vi(b) << "));\n";
+            src << "            " << vr(o) << " = ((" << vr(a) << " * " << vr(b) << ") + (" << vi(a) << " * " << vi(b) << ")) * c;\n";
+            src << "            " << vi(o) << " = ((-" << vr(a) << " * " << vi(b) << ") + (" << vi(a) << " * " << vr(b) << ")) * c;\n";
+            src << "            const double tr = " << dr(a) << " - ((" << vr(o) << " * " << dr(b) << ") - (" << vi(o) << " * " << di(b) << "));\n";
+            src << "            const double ti = " << di(a) << " - ((" << vi(o) << " * " << dr(b) << ") + (" << vr(o) << " * " << di(b) << "));\n";
+            src << "            " << dr(o) << " = ((tr * " << vr(b) << ") + (ti * " << vi(b) << ")) * c;\n";
+            src << "            " << di(o) << " = ((-tr * " << vi(b) << ") + (ti * " << vr(b) << ")) * c;\n";
+            break;
+        case RECIPROCAL:
+            src << "            const double c = 1 / ((" << vr(a) << " * " << vr(a) << ") + (" << vi(a) << " * " << vi(a) << "));\n";
+            src << "            " << vr(o) << " = " << vr(a) << " * c; " << vi(o) << " = -" << vi(a) << " * c;\n";
+            src << "            const double qr = ((" << dr(a) << " * " << vr(a) << ") + (" << di(a) << " * " << vi(a) << ")) * c;\n";
+            src << "            const double qi = ((-" << dr(a) << " * " << vi(a) << ") + (" << di(a) << " * " << vr(a) << ")) * c;\n";
+            src << "            " << dr(o) << " = -((" << vr(o) << " * qr) - (" << vi(o) << " * qi));\n";
+            src << "            " << di(o) << " = -((" << vi(o) << " * qr) + (" << vr(o) << " * qi));\n";
+            break;
+        case SQUARE:
+            src << "            " << vr(o) << " = (" << vr(a) << " * " << vr(a) << ") - (" << vi(a) << " * " << vi(a) << ");\n";
+            src << "            " << vi(o) << " = (" << vi(a) << " * " << vr(a) << ") + (" << vr(a) << " * " << vi(a) << ");\n";
+            src << "            " << dr(o) << " = 2 * ((" << dr(a) << " * " << vr(a) << ") - (" << di(a) << " * " << vi(a) << "));\n";
+            src << "            " << di(o) << " = 2 * ((" << di(a) << " * " << vr(a) << ") + (" << dr(a) << " * " << vi(a) << "));\n";
+            break;
+        case SINCOS:
+            //sine goes to dst, cosine to b
+            src << "            const double sinre = std::sin(" << vr(a) << "), cosre = std::cos(" << vr(a) << ");\n";
+            src << "            const double coshim = std::cosh(" << vi(a) << "), sinhim = std::sinh(" << vi(a) << ");\n";
+            src << "            " << vr(o) << " = sinre * coshim; " << vi(o) << " = cosre * sinhim;\n";
+            src << "            " << vr(b) << " = cosre * coshim; " << vi(b) << " = -sinre * sinhim;\n";
+            src << "            " << dr(o) << " = (" << vr(b) << " * " << dr(a) << ") - (" << vi(b) << " * " << di(a) << ");\n";
+            src << "            " << di(o) << " = (" << vi(b) << " * " << dr(a) << ") + (" << vr(b) << " * " << di(a) << ");\n";
+            src << "            " << dr(b) << " = -((" << vr(o) << " * " << dr(a) << ") - (" << vi(o) << " * " << di(a) << "));\n";
+            src << "            " << di(b) << " = -((" << vi(o) << " * " << dr(a) << ") + (" << vr(o) << " * " << di(a) << "));\n";
+            break;
+        case LN:
+            src << "            const double c = 1 / ((" << vr(a) << " * " << vr(a) << ") + (" << vi(a) << " * " << vi(a) << "));\n";
+            src << "            " << vr(o) << " = std::log(std::sqrt((" << vr(a) << " * " << vr(a) << ") + (" << vi(a) << " * " << vi(a) << ")));\n";
+            src << "            " << vi(o) << " = std::atan2(" << vi(a) << ", " << vr(a) << ");\n";
+            src << "            " << dr(o) << " = ((" << dr(a) << " * " << vr(a) << ") + (" << di(a) << " * " << vi(a) << ")) * c;\n";
+            src << "            " << di(o) << " = ((-" << dr(a) << " * " << vi(a) << ") + (" << di(a) << " * " << vr(a) << ")) * c;\n";
+            break;
+        case POWI:
+        {
+            //x^(b-1) by repeated squaring, unrolled here since the exponent is known
+            src << "            double pr = 1, pi = 0, br = " << vr(a) << ", bi = " << vi(a) << ", t;\n";
+            int m = b - 1;
+            while (m > 0) {
+                if (m & 1) src << "            t = (pr * br) - (pi * bi); pi = (pi * br) + (pr * bi); pr = t;\n";
+                m >>= 1;
+                if (m > 0) src << "            t = (br * br) - (bi * bi); bi = (bi * br) + (br * bi); br = t;\n";
+            }
+            src << "            " << vr(o) << " = (pr * " << vr(a) << ") - (pi * " << vi(a) << ");\n";
+            src << "            " << vi(o) << " = (pi * " << vr(a) << ") + (pr * " << vi(a) << ");\n";
+            src << "            " << dr(o) << " = " << b << " * ((pr * " << dr(a) << ") - (pi * " << di(a) << "));\n";
+            src << "            " << di(o) << " = " << b << " * ((pi * " << dr(a) << ") + (pr * " << di(a) << "));\n";
+            break;
+        }
+        case POWER:
+            src << "            const double c = 1 / ((" << vr(a) << " * " << vr(a) << ") + (" << vi(a) << " * " << vi(a) << "));\n";
+            src << "            const double lr = std::log(std::sqrt((" << vr(a) << " * " << vr(a) << ") + (" << vi(a) << " * " << vi(a) << ")));\n";
+            src << "            const double li = std::atan2(" << vi(a) << ", " << vr(a) << ");\n";
+            src << "            const double er = (" << vr(b) << " * lr) - (" << vi(b) << " * li), ei = (" << vi(b) << " * lr) + (" << vr(b) << " * li);\n";
+            src << "            " << vr(o) << " = std::exp(er) * std::cos(ei); " << vi(o) << " = std::exp(er) * std::sin(ei);\n";
+            src << "            const double qr = ((" << dr(a) << " * " << vr(a) << ") + (" << di(a) << " * " << vi(a) << ")) * c;\n";
+            src << "            const double qi = ((-" << dr(a) << " * " << vi(a) << ") + (" << di(a) << " * " << vr(a) << ")) * c;\n";
+            src << "            const double tr = ((" << dr(b) << " * lr) - (" << di(b) << " * li)) + ((" << vr(b) << " * qr) - (" << vi(b) << " * qi));\n";
+            src << "            const double ti = ((" << di(b) << " * lr) + (" << dr(b) << " * li)) + ((" << vi(b) << " * qr) + (" << vr(b) << " * qi));\n";
+            src << "            " << dr(o) << " = (" << vr(o) << " * tr) - (" << vi(o) << " * ti);\n";
+            src << "            " << di(o) << " = (" << vi(o) << " * tr) + (" << vr(o) << " * ti);\n";
+            break;
+        default:
+            throw 5;
+        }
+        src << "        }\n";
+    }
+
+    int r = function.result;
+    src << "        const double c = 1 / ((" << dr(r) << " * " << dr(r) << ") + (" << di(r) << " * " << di(r) << "));\n";
+    src << "        re[lane] = v0r - (((" << vr(r) << " * " << dr(r) << ") + (" << vi(r) << " * " << di(r) << ")) * c);\n";
+    src << "        im[lane] = v0i - (((-" << vr(r) << " * " << di(r) << ") + (" << vi(r) << " * " << dr(r) << ")) * c);\n";
+    src << "    }\n";
+    src << "}\n";
+    return src.str();
+}
+
+/// @return the command kernels are built with, up to the output and source files
+std::string compile_command() {
+    const char* compiler = std::getenv("CXX");
+    return std::string(compiler ? compiler : "c++") + " -O3 -march=native -ffast-math -shared -fPIC";
+}
+
+/// @return the model and instruction set extensions of the cpu, which -march=native builds for, or nothing if
+/// they can't be read. Kernels in a ./kernels shared between machines then aren't loaded on the wrong cpu
+std::string cpu_signature() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line, signature;
+    bool model = false, features = false;
+    while (std::getline(cpuinfo, line) && !(model && features)) {
+        if (!model && line.rfind("model name", 0) == 0) {
+            signature += line + "\n";
+            model = true;
+        }
+        //x86 calls them flags and arm features
+        else if (!features && (line.rfind("flags", 0) == 0 || line.rfind("Features", 0) == 0)) {
+            signature += line + "\n";
+            features = true;
+        }
+    }
+    return signature;
+}
+
+/// @brief FNV-1a hash of the RPN stack, with the exact bits of every number, and of what the kernel is built with and for
+unsigned long long kernel_hash(func& function) {
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    auto add = [&](const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    int version = KERNEL_VERSION;
+    int lanes = BATCH_SIZE;
+    add(&version, sizeof(version));
+    add(&lanes, sizeof(lanes));
+    std::string build = compile_command() + "\n" + cpu_signature();
+    add(build.data(), build.size());
+    for (int i = 0; i < function.stack.size(); i++) {
+        add(&function.stack[i], sizeof(function.stack[i]));
+        if (function.stack[i] == NUMBER) {
+            add(&function.number_stack[i].re, sizeof(double));
+            add(&function.number_stack[i].im, sizeof(double));
+        }
+    }
+    return hash;
+}
+
+newtonKernel compile_kernel(func& function) {
+#ifdef _WIN32
+    std::cout << "Native kernels are not supported on windows, using the interpreter" << std::endl;
+    return nullptr;
+#else
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", kernel_hash(function));
+    std::string library = "./kernels/" + std::string(name) + ".so";
+
+    if (!std::filesystem::exists(library)) {
+        std::cout << "Compiling kernel..." << std::endl;
+        std::error_code error;
+        std::filesystem::create_directories("./kernels", error);
+        //build under names only this process uses, so an interrupted build never ends up in the cache and two
+        //renders building the same kernel at once don't write over each other's files
+        std::string temporary = "./kernels/" + std::string(name) + "." + std::to_string(getpid());
+        std::string source = temporary + ".cpp";
+        std::ofstream file(source);
+        file << kernel_source(function);
+        file.close();
+        if (!file) {
+            std::cout << "Could not write kernel source, using the interpreter" << std::endl;
+            std::filesystem::remove(source, error);
+            return nullptr;
+        }
+
+        temporary += ".so";
+        std::string command = compile_command() + " -o \"" + temporary + "\" \"" + source + "\"";
+        bool compiled = std::system(command.c_str()) == 0;
+        std::filesystem::remove(source, error);
+        if (!compiled) {
+            std::cout << "Could not compile kernel, using the interpreter" << std::endl;
+            std::filesystem::remove(temporary, error);
+            return nullptr;
+        }
+        //renaming is atomic, so another render sees either no kernel or a whole one
+        std::filesystem::rename(temporary, library, error);
+        if (error) {
+            std::cout << "Could not save kernel, using the interpreter" << std::endl;
+            return nullptr;
+        }
+    }
+
+    void* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        std::cout << "Could not load kernel: " << dlerror() << ", using the interpreter" << std::endl;
+        return nullptr;
+    }
+    newtonKernel kernel = (newtonKernel)dlsym(handle, "newton_step");
+    if (kernel == nullptr) {
+        std::cout << "Kernel is missing newton_step, using the interpreter" << std::endl;
+        dlclose(handle);
+        return nullptr;
+    }
+    std::cout << "Using native kernel " << library << std::endl;
+    return kernel;
+#endif
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include "function.hpp"
+
+/// @brief Turn a compiled function into C++ source for a newton step kernel (see newtonKernel)
+std::string kernel_source(func& function);
+
+/// @brief Compile the function to native code with the installed compiler and load it. Kernels are cached
+/// in ./kernels/ by a hash of the function, the compile command and the cpu, so the same function only has to be
+/// compiled once on each machine
+/// @return the loaded kernel, or nullptr if it could not be built (the interpreter is used instead)
+newtonKernel compile_kernel(func& function);
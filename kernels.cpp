@@ -0,0 +1,36 @@
+#include "kernels.hpp"
+
+//Functions that get a kernel compiled into the program. A user function uses one of these if it
+//parses to exactly the same RPN, so the strings must be written the way users write them
+const builtinKernel builtinKernels[] = {
+    NEWTON_KERNEL("x^3-1", Sub<Pow<Var, 3>, Const<1>>),
+    NEWTON_KERNEL("x^4-1", Sub<Pow<Var, 4>, Const<1>>),
+    NEWTON_KERNEL("x^5-1", Sub<Pow<Var, 5>, Const<1>>),
+    NEWTON_KERNEL("x^6-1", Sub<Pow<Var, 6>, Const<1>>),
+    NEWTON_KERNEL("x^8-1", Sub<Pow<Var, 8>, Const<1>>),
+    NEWTON_KERNEL("x^3-2x+2", Add<Sub<Pow<Var, 3>, Mul<Const<2>, Var>>, Const<2>>),
+    NEWTON_KERNEL("x^3-x", Sub<Pow<Var, 3>, Var>),
+    NEWTON_KERNEL("x*x*x-1", Sub<Pow<Var, 3>, Const<1>>),
+    NEWTON_KERNEL("x*x*x*x-1", Sub<Pow<Var, 4>, Const<1>>),
+    NEWTON_KERNEL("x*x*x*x*x-1", Sub<Pow<Var, 5>, Const<1>>),
+    NEWTON_KERNEL("x*x*x*x*x*x-1", Sub<Pow<Var, 6>, Const<1>>),
+    NEWTON_KERNEL("x*x*x*x*x*x*x*x-1", Sub<Pow<Var, 8>, Const<1>>),
+    NEWTON_KERNEL("x*x*x-2x+2", Add<Sub<Pow<Var, 3>, Mul<Const<2>, Var>>, Const<2>>),
+    NEWTON_KERNEL("x*x*x-x", Sub<Pow<Var, 3>, Var>),
+    NEWTON_KERNEL("sin(x)", Sin<Var>),
+    NEWTON_KERNEL("cos(x)", Cos<Var>),
+    NEWTON_KERNEL("sin(x)-x", Sub<Sin<Var>, Var>),
+    NEWTON_KERNEL("ln(x)-1", Sub<Ln<Var>, Const<1>>),
+};
+
+newtonKernel find_kernel(func& function) {
+    for (const builtinKernel& builtin : builtinKernels) {
+        func candidate;
+        candidate.init(builtin.function, false);
+        if (candidate.matches(function)) {
+            std::cout << "Using built-in kernel for " << builtin.function << std::endl;
+            return builtin.kernel;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <cmath>
+#include "function.hpp"
+
+//Expression templates for newton step kernels that are built into the program. Each expression type
+//has a static eval() that returns the value and derivative at x, so a whole kernel inlines into straight
+//line code with no interpreter. Add new kernels to the table in kernels.cpp with NEWTON_KERNEL
+
+/// @brief value and derivative as plain doubles, the built-in version of dual
+struct jet {
+    double re, im, dre, dim;
+};
+
+inline jet operator + (const jet& a, const jet& b) {
+    return jet{ a.re + b.re, a.im + b.im, a.dre + b.dre, a.dim + b.dim };
+}
+
+inline jet operator - (const jet& a, const jet& b) {
+    return jet{ a.re - b.re, a.im - b.im, a.dre - b.dre, a.dim - b.dim };
+}
+
+inline jet operator * (const jet& a, const jet& b) {
+    return jet{ (a.re * b.re) - (a.im * b.im), (a.im * b.re) + (a.re * b.im),
+        ((a.dre * b.re) - (a.dim * b.im)) + ((a.re * b.dre) - (a.im * b.dim)),
+        ((a.dim * b.re) + (a.dre * b.im)) + ((a.im * b.dre) + (a.re * b.dim)) };
+}
+
+inline jet operator / (const jet& a, const jet& b) {
+    double c = 1 / ((b.re * b.re) + (b.im * b.im));
+    double re = ((a.re * b.re) + (a.im * b.im)) * c;
+    double im = ((-a.re * b.im) + (a.im * b.re)) * c;
+    double tre = a.dre - ((re * b.dre) - (im * b.dim));
+    double tim = a.dim - ((im * b.dre) + (re * b.dim));
+    return jet{ re, im, ((tre * b.re) + (tim * b.im)) * c, ((-tre * b.im) + (tim * b.re)) * c };
+}
+
+/// @brief the variable
+struct Var {
+    static jet eval(const jet& x) { return x; }
+};
+
+/// @brief an integer constant
+template<int N>
+struct Const {
+    static jet eval(const jet&) { return jet{ double(N), 0, 0, 0 }; }
+};
+
+/// @brief an imaginary integer constant
+template<int N>
+struct Imag {
+    static jet eval(const jet&) { return jet{ 0, double(N), 0, 0 }; }
+};
+
+template<class A, class B>
+struct Add {
+    static jet eval(const jet& x) { return A::eval(x) + B::eval(x); }
+};
+
+template<class A, class B>
+struct Sub {
+    static jet eval(const jet& x) { return A::eval(x) - B::eval(x); }
+};
+
+template<class A, class B>
+struct Mul {
+    static jet eval(const jet& x) { return A::eval(x) * B::eval(x); }
+};
+
+template<class A, class B>
+struct Div {
+    static jet eval(const jet& x) { return A::eval(x) / B::eval(x); }
+};
+
+/// @brief A to a positive integer power, unrolled into squares and multiplies. The interpreter multiplies
+/// A^(N-1) by A instead, so from the 4th power up a step can differ from it in the last bits
+template<class A, int N>
+struct Pow {
+    static jet eval(const jet& x) { return power<N>(A::eval(x)); }
+
+    template<int M>
+    static jet power(const jet& a) {
+        if constexpr (M == 1) return a;
+        else if constexpr (M % 2 == 0) {
+            jet half = power<M / 2>(a);
+            return half * half;
+        }
+        else return power<M - 1>(a) * a;
+    }
+};
+
+template<class A>
+struct Sin {
+    static jet eval(const jet& x) {
+        jet a = A::eval(x);
+        double sinre = std::sin(a.re), cosre = std::cos(a.re), coshim = std::cosh(a.im), sinhim = std::sinh(a.im);
+        double cre = cosre * coshim, cim = -sinre * sinhim;
+        return jet{ sinre * coshim, cosre * sinhim, (cre * a.dre) - (cim * a.dim), (cim * a.dre) + (cre * a.dim) };
+    }
+};
+
+template<class A>
+struct Cos {
+    static jet eval(const jet& x) {
+        jet a = A::eval(x);
+        double sinre = std::sin(a.re), cosre = std::cos(a.re), coshim = std::cosh(a.im), sinhim = std::sinh(a.im);
+        double sre = sinre * coshim, sim = cosre * sinhim;
+        return jet{ cosre * coshim, -sinre * sinhim, -((sre * a.dre) - (sim * a.dim)), -((sim * a.dre) + (sre * a.dim)) };
+    }
+};
+
+template<class A>
+struct Ln {
+    static jet eval(const jet& x) {
+        jet a = A::eval(x);
+        double c = 1 / ((a.re * a.re) + (a.im * a.im));
+        return jet{ std::log(std::sqrt((a.re * a.re) + (a.im * a.im))), std::atan2(a.im, a.re),
+            ((a.dre * a.re) + (a.dim * a.im)) * c, ((-a.dre * a.im) + (a.dim * a.re)) * c };
+    }
+};
+
+/// @brief newton step for the function F on BATCH_SIZE points, has the same signature as a jit kernel
+template<class F>
+void newton_step(double* re, double* im) {
+    for (int lane = 0; lane < BATCH_SIZE; lane++) {
+        jet f = F::eval(jet{ re[lane], im[lane], 1, 0 });
+        double c = 1 / ((f.dre * f.dre) + (f.dim * f.dim));
+        re[lane] -= ((f.re * f.dre) + (f.im * f.dim)) * c;
+        im[lane] -= ((-f.re * f.dim) + (f.im * f.dre)) * c;
+    }
+}
+
+/// @brief a function string and the kernel that is used when the user's function matches it
+struct builtinKernel {
+    const char* function;
+    newtonKernel kernel;
+};
+
+#define NEWTON_KERNEL(function, ...) builtinKernel{ function, newton_step<__VA_ARGS__> }
+
+/// @brief Look for a built-in kernel for the function
+/// @return the kernel, or nullptr if the function has none
+newtonKernel find_kernel(func& function);
@@ -1,26 +1,71 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <future>
 #include <thread>
 #include <chrono>
-#include <set>
 #include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
+#include <future>
+#include <functional>
 #include "complex.hpp"
 #include "function.hpp"
 #include "bmp.hpp"
+#include "png.hpp"
+#include "framebuffer.hpp"
+#include "jit.hpp"
+#include "kernels.hpp"
+#include "roots.hpp"
+#include "scheduler.hpp"
 
+//default for -maxsteps
 constexpr auto MAX_STEPS = 1000;
 
+//largest -maxsteps, steps are counted in a short
+constexpr auto MAX_STEPS_LIMIT = 30000;
+
+//an orbit further out than this that is still moving away is taken as diverging
+constexpr auto DIVERGENCE_RADIUS = 1e10;
+
+//most newton steps a newly found root is polished with, a root of multiplicity m only gets (m-1)/m closer each step
+constexpr auto POLISH_STEPS = 100;
+
+//a root where |f'| is below this is taken as a multiple root, which mixed precision does in double
+constexpr auto MULTIPLE_ROOT_DERIVATIVE = 1e-6;
+
+//results closer than 10 times this are the same root
 constexpr auto accuracy = 0.001;
 
+//default step size that a pixel is done at as a fraction of the pixel size, 0.4 of a pixel at the default
+//zoom of 400 is the 0.001 that used to be fixed. Past a quarter of the distance between roots that are given
+//different colors a bigger step could land on the wrong one
+constexpr auto TOLERANCE_PER_PIXEL = 0.4;
+constexpr auto MAX_TOLERANCE = accuracy * 2.5;
+
+//the image is split into square tiles this size that the workers take one at a time
+constexpr auto TILE_SIZE = 32;
+
+//-trace uses bigger tiles, which are then split in half until their border is all one root and number of steps
+constexpr auto TRACE_TILE_SIZE = 64;
+
+//tiles narrower or shorter than this are evaluated in full instead of split again
+constexpr auto TRACE_MIN_TILE = 6;
+
+//the inside of a tile is checked on a grid this many points across before it is filled, a root or a dip in steps
+//can be inside a border that looks smooth
+constexpr auto TRACE_CHECKS = 3;
+
+//with -adaptive every pixel is sampled at least this many times once it is found on a boundary, and keeps
+//getting samples up to -samplecout while they don't all find the same root
+constexpr auto ADAPTIVE_MIN_SAMPLES = 4;
+
+//a pixel whose steps are further than this from a pixel next to it is on a boundary as well, bands of shading alias too
+constexpr auto ADAPTIVE_STEP_JUMP = 4;
+
 constexpr auto progressBarLength = 30;
 
-#ifdef _debug
-constexpr auto MULTITHREADED = false;
-#else
-constexpr auto MULTITHREADED = true;
-#endif
 
 typedef enum showRoots{
     DEFAULT,
@@ -28,14 +73,52 @@ typedef enum showRoots{
     NONE
 } showRoots;
 
+typedef enum precisionMode{
+    PRECISION_AUTO,
+    PRECISION_MIXED,
+    PRECISION_FLOAT,
+    PRECISION_DOUBLE,
+    PRECISION_DOUBLE_DOUBLE,
+    PRECISION_QUAD_DOUBLE
+} precisionMode;
+
+typedef enum imageFormat{
+    FORMAT_BMP,
+    FORMAT_PNG,
+    FORMAT_PNG_PALETTE
+} imageFormat;
+
+typedef enum iterationEngine{
+    ENGINE_NEWTON,
+    ENGINE_RELAXED,
+    ENGINE_HALLEY,
+    ENGINE_HOUSEHOLDER
+} iterationEngine;
+
 struct renderOptions{
     int imgwidth = -1;
     int imgheight = -1;
+    //when the image is rendered in bands imgheight is the height of one band, bandTop is the row of the image the
+    //band starts at and totalHeight is the height of the whole image. totalHeight is 0 when there are no bands
+    int bandTop = 0;
+    int totalHeight = 0;
+    //column of the image that column 0 of the results is, for results planes that only cover part of the image
+    int bandLeft = 0;
     int samples = 0;
     complex offset = complex(NAN,NAN);
+    //the same offset with every digit that was given, for deep zooms
+    basicComplex<quadDouble> preciseOffset = basicComplex<quadDouble>(NAN,NAN);
     double zoom = 0;
 
-    unsigned char processor_count = std::thread::hardware_concurrency();
+    unsigned int processor_count = std::max(std::thread::hardware_concurrency(), 1u);
+    //keep each worker on one cpu, see workerPool
+    bool affinity = false;
+    //render straight into the output file instead of keeping the image in memory, see bmp::map
+    bool mapFile = false;
+    //megabytes the image can take while it is rendered, 0 to keep all of it in memory. See renderBands
+    int memoryLimit = 0;
+    //file the image is saved as, a png with a palette is only indexed if the image has 256 colors or less
+    imageFormat format = FORMAT_BMP;
 
     std::string title = "";
     std::string functionString = "";
@@ -46,9 +129,54 @@ struct renderOptions{
     bool pauseOnFinish = true;
     bool useDefaultValues = false;
     bool displayPercent = true;
-    
+    bool jit = false;
+    bool colorCycles = false;
+    //only evaluate the borders of tiles and fill the ones with one root and number of steps on their whole border
+    bool trace = false;
+    //take one sample of every pixel and up to samples of the pixels on the boundaries between basins
+    bool adaptive = false;
+
+    precisionMode precision = PRECISION_AUTO;
+
+    //iteration method, relaxation is the fraction of each newton step taken by relaxed newton and
+    //order is the order of the householder method, 2 is the same as halley
+    iterationEngine engine = ENGINE_NEWTON;
+    double relaxation = 0.5;
+    int order = 3;
+
+    //a pixel is done once a step is smaller than tolerance and |f| is within a pixel of 0 going by |f'|, or gives up after maxSteps.
+    //tolerance is NAN until it is worked out from the zoom
+    double tolerance = NAN;
+    int maxSteps = MAX_STEPS;
+
 };
 
+/// @brief column and row of a pixel in the image, and which of its samples to take
+struct pixelPosition {
+    int column;
+    int row;
+    int sample = 0;
+};
+
+/// @brief mixes the bits of v so every bit of the output depends on every bit of the input (splitmix64)
+inline uint64_t mixBits(uint64_t v) {
+    v = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9;
+    v = (v ^ (v >> 27)) * 0x94D049BB133111EB;
+    return v ^ (v >> 31);
+}
+
+/// @return where in a pixel a sample is taken, from -0.5 to 0.5 of a pixel each way. The samples of a pixel follow the
+/// R2 sequence, which spreads any number of samples evenly over the pixel, shifted by an amount hashed from the pixel
+/// so neighbouring pixels don't line up. Only depends on its arguments, so renders come out the same on any number of threads
+complex sampleOffset(int column, int row, int sample) {
+    //the plastic number, the 2d version of the golden ratio
+    const double g = 1.32471795724474602596;
+    uint64_t hash = mixBits((uint64_t(uint32_t(column)) << 32) | uint32_t(row));
+    double re = (hash >> 40) / double(1 << 24) + sample / g;
+    double im = ((hash >> 16) & 0xFFFFFF) / double(1 << 24) + sample / (g * g);
+    return complex(re - floor(re) - 0.5, im - floor(im) - 0.5);
+}
+
 //Asks the user for input until a valid response is given
 bool getInput(std::string question) {
     std::string choice;
@@ -80,97 +208,707 @@ T getInput(std::string question) {
 }
 
 
-/// @brief negative zero is hard to remove in Ofast
-/// @param v pointer to double to use
-void removeNegativeZero(double* v){
-    unsigned long long* g = (unsigned long long*)(v);
-    if(*g == 0x8000000000000000)
-        *g = 0;
-    
-}
-
-/// @brief weird hash funtion that takes in a complex number
-/// @param input complex number
-/// @return integer
-unsigned long long simpleHash(complex input){
-    removeNegativeZero(&input.re);
-    removeNegativeZero(&input.im);
-    unsigned long long output = 0;
-    //make a float pointer with the same adress as output
-    float* floatptr = (float*)(&output);
-    *floatptr = input.re + 0;
-    *(floatptr + 1) = input.im + 0;
-    return output;
-}
-
 /// @brief Go through one iteration of newtons method
 /// @param function referance to function to be evaluated
 /// @param input input to iterate
 /// @return value after one iteration
 complex iterate(func& function, complex input) {
-    complex a = function.evaluate_function(input);
-    //use nextafter to calculate a suitible value of dx based on precicion of floats
-    auto dx = complex(nextafterf(input.re,INFINITY) - input.re);
-    dx = dx * 10;
-    return input - ((dx * a) / (function.evaluate_function(dx + input) - a));
+    //f and f' come from a single forward mode pass instead of a finite difference
+    dual a = function.evaluate_dual(input);
+    return input - (a.value / a.derivative);
 }
 
-/// @brief Find a root of the function by iterating newtons method. Also adds number of iterations taken 
-/// @param function reference to funtion object to be evaluated
-/// @param input starting point for newtons method
-/// @param shading reference to value where number of iterations taken to find root will be stored
-/// @return root that is found
-complex newtons_method(func& function, complex input, short& steps) {
-    complex value;
-    value = input;
+/// @return a root rounded to the digits it is printed with, without a negative zero for a root that is just off an axis
+complex roundedRoot(complex root) {
+    const double digits = 1e6;
+    return complex(std::round(root.re * digits) / digits + 0.0, std::round(root.im * digits) / digits + 0.0);
+}
 
-    while (steps < MAX_STEPS) {
-            value = iterate(function, input);
-            input = iterate(function, value);
-            steps += 2;
-        auto difference = abs(value - input);
-        if (difference.re < accuracy && difference.im < accuracy) {
+/// @brief Take a result the rest of the way to its root, so the root a registry keeps is the same whichever pixel found it
+/// @return the closest value to the root newtons method gets to in double, or INFINITY/NAN if it fails
+complex polishRoot(func& function, complex value) {
+    for (int i = 0; i < POLISH_STEPS; i++) {
+        complex next = iterate(function, value);
+        if (!std::isfinite(next.re) || !std::isfinite(next.im))
+            return next;
+        //a step that can't move it is as close as double gets
+        if (next.re == value.re && next.im == value.im)
             break;
+        value = next;
+    }
+    return value;
+}
+
+/// @brief Evaluate a polynomial and its derivative for every lane of a batch using Horner's method
+template<typename T>
+void evaluate(polynomial& p, const basicComplexBatch<T>& x, basicComplexBatch<T>& value, basicComplexBatch<T>& derivative) {
+    //work on local copies so the compiler knows nothing aliases and can vectorize across lanes
+    T xre[batchSize<T>], xim[batchSize<T>], vre[batchSize<T>], vim[batchSize<T>], dre[batchSize<T>], dim[batchSize<T>];
+    for (int i = 0; i < batchSize<T>; i++) {
+        xre[i] = x.re[i];
+        xim[i] = x.im[i];
+        vre[i] = p.coefficients.back().re;
+        vim[i] = p.coefficients.back().im;
+        dre[i] = 0;
+        dim[i] = 0;
+    }
+    for (int k = p.coefficients.size() - 2; k >= 0; k--) {
+        T cre = p.coefficients[k].re;
+        T cim = p.coefficients[k].im;
+        //stop gcc from unrolling the lanes into scalar code before it gets the chance to vectorize them
+        #pragma GCC unroll 1
+        for (int i = 0; i < batchSize<T>; i++) {
+            T nextdre = (dre[i] * xre[i]) - (dim[i] * xim[i]) + vre[i];
+            T nextdim = (dim[i] * xre[i]) + (dre[i] * xim[i]) + vim[i];
+            T nextvre = (vre[i] * xre[i]) - (vim[i] * xim[i]) + cre;
+            T nextvim = (vim[i] * xre[i]) + (vre[i] * xim[i]) + cim;
+            dre[i] = nextdre;
+            dim[i] = nextdim;
+            vre[i] = nextvre;
+            vim[i] = nextvim;
+        }
+    }
+    for (int i = 0; i < batchSize<T>; i++) {
+        value.re[i] = vre[i];
+        value.im[i] = vim[i];
+        derivative.re[i] = dre[i];
+        derivative.im[i] = dim[i];
+    }
+}
+
+/// @brief Go through one iteration of newtons method for every lane of a batch on a ratio of polynomials p/q,
+/// where f/f' = pq/(p'q - pq'), or just p/p' if q is a constant
+template<typename T>
+void iterate(polynomial& numerator, polynomial& denominator, basicComplexBatch<T>& input) {
+    basicComplexBatch<T> p, dp, q, dq;
+    evaluate(numerator, input, p, dp);
+    if (denominator.degree() > 0) {
+        evaluate(denominator, input, q, dq);
+        for (int i = 0; i < batchSize<T>; i++) {
+            T nre = (p.re[i] * q.re[i]) - (p.im[i] * q.im[i]);
+            T nim = (p.im[i] * q.re[i]) + (p.re[i] * q.im[i]);
+            T dre = ((dp.re[i] * q.re[i]) - (dp.im[i] * q.im[i])) - ((p.re[i] * dq.re[i]) - (p.im[i] * dq.im[i]));
+            T dim = ((dp.im[i] * q.re[i]) + (dp.re[i] * q.im[i])) - ((p.im[i] * dq.re[i]) + (p.re[i] * dq.im[i]));
+            p.re[i] = nre;
+            p.im[i] = nim;
+            dp.re[i] = dre;
+            dp.im[i] = dim;
+        }
+    }
+    for (int i = 0; i < batchSize<T>; i++) {
+        T c = 1 / ((dp.re[i] * dp.re[i]) + (dp.im[i] * dp.im[i]));
+        input.re[i] -= ((p.re[i] * dp.re[i]) + (p.im[i] * dp.im[i])) * c;
+        input.im[i] -= ((-p.re[i] * dp.im[i]) + (p.im[i] * dp.re[i])) * c;
+    }
+}
+
+/// @brief Go through one iteration of newtons method for every lane of a batch
+/// @param function referance to function to be evaluated
+/// @param input values to iterate, overwritten with the values after one iteration
+template<typename T>
+void iterate(func& function, basicComplexBatch<T>& input) {
+    //native kernels only work on doubles
+    if constexpr (std::is_same<T, double>::value) {
+        if (function.kernel) {
+            function.kernel(input.re, input.im);
+            return;
         }
     }
-    if (steps >= MAX_STEPS - 1) {
-        steps = 0;
-        return NAN;
+    if (function.rational) {
+        iterate(function.numerator, function.denominator, input);
+        return;
+    }
+    const basicDualBatch<T>& a = function.evaluate_batch(input);
+    for (int i = 0; i < batchSize<T>; i++) {
+        T c = 1 / ((a.derivative.re[i] * a.derivative.re[i]) + (a.derivative.im[i] * a.derivative.im[i]));
+        input.re[i] -= ((a.value.re[i] * a.derivative.re[i]) + (a.value.im[i] * a.derivative.im[i])) * c;
+        input.im[i] -= ((-a.value.re[i] * a.derivative.im[i]) + (a.value.im[i] * a.derivative.re[i])) * c;
     }
-    return input;
 }
 
-/// @brief Evaluates a section of the image
-/// @param offset offset of the 0 value of the whole image
-/// @param scale scale of the image
-/// @param imgheight pixel height of image
-/// @param imgwidth pixel width of image
-/// @param start x pixel value to start 
-/// @param end x pixel value to end
-/// @param function function object to evaluate
-/// @param values referance to 2d vector of values to output
-/// @param shading referance to 2d vector of shading values
-/// @param progressCounter referance to progress counter
-void evalSection(const renderOptions options, char thread, func function, std::vector<std::vector<complex>>& values, std::vector<std::vector<short>>& shading, unsigned int& progressCounter) {
-    try {
-        for (int i = 0 + thread; i < options.imgwidth; i += options.processor_count) {
-            for (int j = 0; j < options.imgheight; j++)
-            {
-                values[i][j] = newtons_method(function, complex(i - options.imgwidth / 2, j - options.imgheight / 2) * (1 / options.zoom) + options.offset, shading[i][j]);
+/// @brief Evaluate the first terms of the taylor series of a polynomial for every lane of a batch using Horner's method,
+/// with one running sum per term that is fed by the one below it
+template<typename T>
+void evaluate(polynomial& p, const basicComplexBatch<T>& x, basicTaylorBatch<T>& out, int terms) {
+    for (int j = 0; j < terms; j++) {
+        for (int i = 0; i < batchSize<T>; i++) {
+            out.term[j].re[i] = j == 0 ? T(p.coefficients.back().re) : T(0);
+            out.term[j].im[i] = j == 0 ? T(p.coefficients.back().im) : T(0);
+        }
+    }
+    for (int k = p.coefficients.size() - 2; k >= 0; k--) {
+        //highest term first so each one adds the term below it from before this coefficient
+        for (int j = terms - 1; j >= 0; j--) {
+            basicComplexBatch<T>& sum = out.term[j];
+            for (int i = 0; i < batchSize<T>; i++) {
+                T addre = j > 0 ? out.term[j - 1].re[i] : T(p.coefficients[k].re);
+                T addim = j > 0 ? out.term[j - 1].im[i] : T(p.coefficients[k].im);
+                T re = (sum.re[i] * x.re[i]) - (sum.im[i] * x.im[i]) + addre;
+                T im = (sum.im[i] * x.re[i]) + (sum.re[i] * x.im[i]) + addim;
+                sum.re[i] = re;
+                sum.im[i] = im;
             }
-            progressCounter++;
         }
     }
-    catch (int exc) {
-        if (exc == 5) {
-            std::cout << "Evaluation error" << std::endl;
+}
+
+/// @brief Go through one step of the householder method of some order for every lane of a batch, order 1 is newtons method
+/// and order 2 is halley's method. With f_k the taylor terms of f the step is f_0*h_(d-1)/h_d where h_k = -sum of f_j*h_(k-j)*f_0^(j-1),
+/// which is the k-th term of 1/f times f_0^(k+1) so nothing is divided by f_0 as it goes to 0 near a root
+/// @param f first order + 1 taylor terms of the function at input
+/// @param input values to iterate, overwritten with the values after one step
+template<typename T>
+void householder(const basicTaylorBatch<T>& f, int order, basicComplexBatch<T>& input) {
+    basicComplexBatch<T> h[MAX_TAYLOR_TERMS], power[MAX_TAYLOR_TERMS];
+    for (int i = 0; i < batchSize<T>; i++) {
+        h[0].re[i] = 1;
+        h[0].im[i] = 0;
+        power[0].re[i] = 1;
+        power[0].im[i] = 0;
+    }
+    for (int j = 1; j < order; j++) {
+        for (int i = 0; i < batchSize<T>; i++) {
+            power[j].re[i] = (power[j - 1].re[i] * f.term[0].re[i]) - (power[j - 1].im[i] * f.term[0].im[i]);
+            power[j].im[i] = (power[j - 1].im[i] * f.term[0].re[i]) + (power[j - 1].re[i] * f.term[0].im[i]);
+        }
+    }
+    for (int k = 1; k <= order; k++) {
+        for (int i = 0; i < batchSize<T>; i++) {
+            h[k].re[i] = 0;
+            h[k].im[i] = 0;
+        }
+        for (int j = 1; j <= k; j++) {
+            for (int i = 0; i < batchSize<T>; i++) {
+                T are = (f.term[j].re[i] * power[j - 1].re[i]) - (f.term[j].im[i] * power[j - 1].im[i]);
+                T aim = (f.term[j].im[i] * power[j - 1].re[i]) + (f.term[j].re[i] * power[j - 1].im[i]);
+                h[k].re[i] -= (are * h[k - j].re[i]) - (aim * h[k - j].im[i]);
+                h[k].im[i] -= (aim * h[k - j].re[i]) + (are * h[k - j].im[i]);
+            }
+        }
+    }
+    for (int i = 0; i < batchSize<T>; i++) {
+        T nre = (f.term[0].re[i] * h[order - 1].re[i]) - (f.term[0].im[i] * h[order - 1].im[i]);
+        T nim = (f.term[0].im[i] * h[order - 1].re[i]) + (f.term[0].re[i] * h[order - 1].im[i]);
+        T dre = h[order].re[i], dim = h[order].im[i];
+        T c = 1 / ((dre * dre) + (dim * dim));
+        input.re[i] += ((nre * dre) + (nim * dim)) * c;
+        input.im[i] += ((-nre * dim) + (nim * dre)) * c;
+    }
+}
+
+/// @return order of the method the engine uses, the number of taylor terms it needs is one more
+int engineOrder(const renderOptions& options) {
+    switch (options.engine) {
+    case ENGINE_HALLEY:
+        return 2;
+    case ENGINE_HOUSEHOLDER:
+        return options.order;
+    default:
+        return 1;
+    }
+}
+
+/// @brief Go through one step of the iteration method set in the options for every lane of a batch
+/// @param function referance to function to be evaluated
+/// @param input values to iterate, overwritten with the values after one step
+template<typename T>
+void iterate(func& function, const renderOptions& options, basicComplexBatch<T>& input) {
+    if (options.engine == ENGINE_NEWTON) {
+        iterate(function, input);
+        return;
+    }
+    //relaxed newton takes part of a newton step, so it can go through any of the ways of doing one
+    if (options.engine == ENGINE_RELAXED) {
+        basicComplexBatch<T> start = input;
+        iterate(function, input);
+        T relaxation = options.relaxation;
+        for (int i = 0; i < batchSize<T>; i++) {
+            input.re[i] = start.re[i] + ((input.re[i] - start.re[i]) * relaxation);
+            input.im[i] = start.im[i] + ((input.im[i] - start.im[i]) * relaxation);
+        }
+        return;
+    }
+    int order = engineOrder(options);
+    if (function.rational) {
+        basicTaylorBatch<T> p, q, f;
+        evaluate(function.numerator, input, p, order + 1);
+        if (function.denominator.degree() > 0) {
+            evaluate(function.denominator, input, q, order + 1);
+            divide(f, p, q, order + 1);
+            householder(f, order, input);
+        }
+        else {
+            householder(p, order, input);
+        }
+        return;
+    }
+    householder(function.evaluate_taylor(input, order + 1), order, input);
+}
+
+/// @brief Find the roots for a list of pixels by iterating newtons method on batchSize<T> pixels at once.
+/// When a lane converges (or runs out of steps) its result is written out and the lane is refilled with the next pixel
+/// @param function reference to funtion object to be evaluated
+/// @param options render options, used to find the starting point of each pixel
+/// @param pixels pixels to evaluate
+/// @param roots gives each root that is found its ID
+/// @param results root and number of iterations found for each pixel, by column then row
+template<typename T>
+void newtons_method(func& function, const renderOptions& options, const std::vector<pixelPosition>& pixels, rootRegistry& roots, framebuffer<pixelResult>& results) {
+    constexpr int lanes = batchSize<T>;
+    basicComplexBatch<T> start, value, input;
+    int column[lanes], row[lanes];
+    short steps[lanes];
+    //brent's cycle detection, each lane is compared to a saved point that moves up to it every time the
+    //number of double steps since it was saved reaches a power of 2
+    T anchorRe[lanes], anchorIm[lanes];
+    short sinceAnchor[lanes], anchorLimit[lanes];
+    int nextPixel = 0;
+    int active = 0;
+    //roots are polished in double, which is as far as iterate goes
+    std::function<complex(const complex&)> polish = [&](const complex& found) { return polishRoot(function, found); };
+
+    //starting points are found in T from the precise offset when T is more precise than double, and in double otherwise
+    typedef typename std::conditional<(sizeof(T) > sizeof(double)), T, double>::type startType;
+    basicComplex<startType> offset = basicComplex<startType>(options.offset.re, options.offset.im);
+    if constexpr (sizeof(T) > sizeof(double))
+        offset = basicComplex<startType>(startType(options.preciseOffset.re), startType(options.preciseOffset.im));
+    startType scale = 1 / startType(options.zoom);
+    int centerRow = (options.totalHeight > 0 ? options.totalHeight : options.imgheight) / 2;
+
+    //a step that is lost in the rounding of T can't get any closer, which deep zooms with a tolerance finer than T can reach
+    T tolerance = T(options.tolerance);
+    T rounding = std::numeric_limits<T>::epsilon() * 4;
+    //how far from 0 f can be at a root, a pixel times |f'| or the tolerance times it if that is looser
+    T residual = T(std::max(1 / options.zoom, options.tolerance));
+    T residualSquared = residual * residual;
+
+    //start a lane on the next pixel, or mark it as unused if there are none left
+    auto refill = [&](int lane) {
+        if (nextPixel < pixels.size()) {
+            const pixelPosition& next = pixels[nextPixel];
+            int imageColumn = next.column + options.bandLeft;
+            int imageRow = next.row + options.bandTop;
+            complex jitter = sampleOffset(imageColumn, imageRow, next.sample);
+            basicComplex<startType> start = basicComplex<startType>(imageColumn - options.imgwidth / 2 + jitter.re, imageRow - centerRow + jitter.im) * scale + offset;
+            input.re[lane] = T(start.re);
+            input.im[lane] = T(start.im);
+            anchorRe[lane] = input.re[lane];
+            anchorIm[lane] = input.im[lane];
+            sinceAnchor[lane] = 0;
+            anchorLimit[lane] = 1;
+            column[lane] = next.column;
+            row[lane] = next.row;
+            steps[lane] = 0;
+            nextPixel++;
+            active++;
         }
         else {
-            std::cout << "Unknown error: " << exc << std::endl;
+            input.re[lane] = 0;
+            input.im[lane] = 0;
+            row[lane] = -1;
+        }
+    };
+    for (int lane = 0; lane < lanes; lane++)
+        refill(lane);
+
+    while (active > 0) {
+        start = input;
+        value = input;
+        iterate(function, options, value);
+        input = value;
+        iterate(function, options, input);
+
+        //if the roots are known, a lane can stop as soon as it is close enough to a root that it can't go anywhere else
+        int captured[lanes];
+        for (int lane = 0; lane < lanes; lane++)
+            captured[lane] = -1;
+        for (int root = 0; root < function.roots.size(); root++) {
+            T radiusSquared = function.attractionRadius[root] * function.attractionRadius[root];
+            T rootre = function.roots[root].re;
+            T rootim = function.roots[root].im;
+            for (int lane = 0; lane < lanes; lane++) {
+                T re = input.re[lane] - rootre;
+                T im = input.im[lane] - rootim;
+                captured[lane] = (re * re) + (im * im) < radiusSquared ? root : captured[lane];
+            }
+        }
+
+        //check every lane at once so only the lanes that are done go through the per pixel work below
+        int done[lanes], failed[lanes], period[lanes], unchecked[lanes];
+        for (int lane = 0; lane < lanes; lane++) {
+            using std::abs;
+            T re = abs(value.re[lane] - input.re[lane]);
+            T im = abs(value.im[lane] - input.im[lane]);
+            steps[lane] += 2;
+            bool finite = isfiniteLane(input.re[lane]) && isfiniteLane(input.im[lane]);
+            T size = abs(input.re[lane]) + abs(input.im[lane]);
+            T step = re > im ? re : im;
+            T previousRe = abs(value.re[lane] - start.re[lane]);
+            T previousIm = abs(value.im[lane] - start.im[lane]);
+            T previousStep = previousRe > previousIm ? previousRe : previousIm;
+            //near a multiple root the steps only shrink by a constant factor, and the distance left is about
+            //step^2/(previousStep - step) instead of about step
+            bool converged = (step < tolerance && step * step <= (previousStep - step) * tolerance) || (re <= size * rounding && im <= size * rounding);
+            unchecked[lane] = converged && captured[lane] == -1 && row[lane] != -1;
+
+            //value is one step after input, so coming back to the saved point can be an odd or even number of steps
+            sinceAnchor[lane]++;
+            T cycleTolerance = T(accuracy * accuracy) * (1 + abs(anchorRe[lane]) + abs(anchorIm[lane]));
+            bool evenCycle = abs(input.re[lane] - anchorRe[lane]) < cycleTolerance && abs(input.im[lane] - anchorIm[lane]) < cycleTolerance;
+            bool oddCycle = abs(value.re[lane] - anchorRe[lane]) < cycleTolerance && abs(value.im[lane] - anchorIm[lane]) < cycleTolerance;
+            period[lane] = converged ? 0 : oddCycle ? 2 * sinceAnchor[lane] - 1 : evenCycle ? 2 * sinceAnchor[lane] : 0;
+            bool moveAnchor = sinceAnchor[lane] == anchorLimit[lane];
+            anchorRe[lane] = moveAnchor ? input.re[lane] : anchorRe[lane];
+            anchorIm[lane] = moveAnchor ? input.im[lane] : anchorIm[lane];
+            anchorLimit[lane] = moveAnchor ? anchorLimit[lane] * 2 : anchorLimit[lane];
+            sinceAnchor[lane] = moveAnchor ? 0 : sinceAnchor[lane];
+
+            T sizeSquared = (input.re[lane] * input.re[lane]) + (input.im[lane] * input.im[lane]);
+            T previousSizeSquared = (value.re[lane] * value.re[lane]) + (value.im[lane] * value.im[lane]);
+            //both steps have to be out there, a step from close to a critical point can be thrown far out and still come back
+            bool diverged = previousSizeSquared > T(DIVERGENCE_RADIUS * DIVERGENCE_RADIUS) && sizeSquared > previousSizeSquared;
+
+            done[lane] = converged || captured[lane] != -1 || steps[lane] >= options.maxSteps || !finite || period[lane] != 0 || diverged;
+            failed[lane] = !finite || period[lane] != 0 || diverged;
+        }
+
+        //the steps only say how far the lane moved, |f|/|f'| where it stopped says how far the root is. A lane that
+        //stopped on its steps also needs that within a pixel, which steps lost in rounding or halley steps can miss
+        bool anyUnchecked = false;
+        for (int lane = 0; lane < lanes; lane++)
+            anyUnchecked = anyUnchecked || unchecked[lane];
+        if (anyUnchecked) {
+            const basicDualBatch<T>& f = function.evaluate_batch(input);
+            for (int lane = 0; lane < lanes; lane++) {
+                T valueSquared = (f.value.re[lane] * f.value.re[lane]) + (f.value.im[lane] * f.value.im[lane]);
+                T derivativeSquared = (f.derivative.re[lane] * f.derivative.re[lane]) + (f.derivative.im[lane] * f.derivative.im[lane]);
+                bool small = valueSquared <= derivativeSquared * residualSquared;
+                done[lane] = unchecked[lane] && !small ? steps[lane] >= options.maxSteps || failed[lane] : done[lane];
+            }
+        }
+
+        for (int lane = 0; lane < lanes; lane++) {
+            if (row[lane] == -1 || !done[lane]) continue;
+            complex result = complex(double(input.re[lane]), double(input.im[lane]));
+
+            //the lane is done, a step through a zero derivative or past the largest float leaves INFINITY or NAN which is a failure too.
+            //an orbit that is stuck in a cycle keeps its length in place of the steps so it can be colored by it
+            if (steps[lane] >= options.maxSteps - 1 || failed[lane]) {
+                results(column[lane], row[lane]) = { NO_ROOT, uint16_t(period[lane]) };
+            }
+            else {
+                //report the exact root instead of wherever the iteration stopped
+                double distance;
+                int root = captured[lane] != -1 ? captured[lane] : function.nearest_root(result, distance);
+                if (captured[lane] != -1 || (root != -1 && distance < accuracy * 10)) result = function.roots[root];
+                uint16_t id = roots.find(result, polish);
+                results(column[lane], row[lane]) = { id, uint16_t(id == NO_ROOT ? 0 : steps[lane]) };
+            }
+            active--;
+            refill(lane);
+        }
+    }
+}
+
+/// @return weather T has enough precision to tell the pixels of a render apart and still reach the tolerance
+template<typename T>
+bool precisionIsEnough(const renderOptions& options) {
+    double largest = std::max(std::abs(options.offset.re), std::abs(options.offset.im)) + std::max(options.imgwidth, options.imgheight) / options.zoom;
+    //leave some bits between the pixel spacing and the smallest difference T can hold, newtons method magnifies errors near the edges of basins
+    double step = largest * double(std::numeric_limits<T>::epsilon()) * 256;
+    return step < 1 / options.zoom && step < options.tolerance;
+}
+
+/// @return step size a pixel is done at when -tolerance isn't given. Wide views stop as soon as the root is
+/// certain and deep views keep going to below a pixel so the step counts still tell neighbouring pixels apart
+double defaultTolerance(const renderOptions& options) {
+    return std::min(TOLERANCE_PER_PIXEL / options.zoom, MAX_TOLERANCE);
+}
+
+/// @return weather two pixels next to each other found results far enough apart that float can't be trusted with them,
+/// a different root or more than a step apart
+inline bool resultsDiffer(const pixelResult& a, const pixelResult& b) {
+    return a.root != b.root || std::abs(int(a.steps) - int(b.steps)) > 1;
+}
+
+/// @brief remembers which roots are multiple roots, where f' goes to 0 too. Newton only gets linearly closer to those,
+/// so the steps float takes to reach the tolerance drift away from the steps double takes
+class multipleRoots {
+public:
+    multipleRoots(func& function, const rootRegistry& roots) : function(function), roots(roots) {}
+
+    bool contains(uint16_t id) {
+        if (id == NO_ROOT)
+            return false;
+        if (id >= known.size())
+            known.resize(id + 1, UNKNOWN);
+        if (known[id] == UNKNOWN) {
+            complex derivative = function.evaluate_dual(roots.root(id)).derivative;
+            known[id] = std::hypot(derivative.re, derivative.im) < MULTIPLE_ROOT_DERIVATIVE ? MULTIPLE : SIMPLE;
+        }
+        return known[id] == MULTIPLE;
+    }
+
+private:
+    enum : char { UNKNOWN, SIMPLE, MULTIPLE };
+    func& function;
+    const rootRegistry& roots;
+    std::vector<char> known;
+};
+
+/// @brief Find the roots for a list of pixels in the precision set in the options.
+/// In mixed precision the pixels are done in float first, then every pixel that didn't converge, went to a multiple
+/// root, or found a different root or a different number of steps than a pixel next to it in the list is done again in double
+void newtons_method(func& function, const renderOptions& options, const std::vector<pixelPosition>& pixels, rootRegistry& roots, framebuffer<pixelResult>& results) {
+    if (options.precision == PRECISION_DOUBLE) {
+        newtons_method<double>(function, options, pixels, roots, results);
+        return;
+    }
+    if (options.precision == PRECISION_FLOAT) {
+        newtons_method<float>(function, options, pixels, roots, results);
+        return;
+    }
+    if (options.precision == PRECISION_DOUBLE_DOUBLE) {
+        newtons_method<doubleDouble>(function, options, pixels, roots, results);
+        return;
+    }
+    if (options.precision == PRECISION_QUAD_DOUBLE) {
+        newtons_method<quadDouble>(function, options, pixels, roots, results);
+        return;
+    }
+
+    newtons_method<float>(function, options, pixels, roots, results);
+
+    multipleRoots multiple(function, roots);
+    std::vector<pixelPosition> promoted;
+    bool differsFromPrevious = false;
+    for (int p = 0; p < pixels.size(); p++) {
+        const pixelPosition& a = pixels[p];
+        const pixelResult& result = results(a.column, a.row);
+        bool differsFromNext = false;
+        if (p < pixels.size() - 1) {
+            const pixelPosition& b = pixels[p + 1];
+            bool neighbours = std::abs(a.column - b.column) + std::abs(a.row - b.row) == 1;
+            differsFromNext = neighbours && resultsDiffer(result, results(b.column, b.row));
+        }
+        if (differsFromPrevious || differsFromNext || result.root == NO_ROOT || multiple.contains(result.root))
+            promoted.push_back(a);
+        differsFromPrevious = differsFromNext;
+    }
+    if (promoted.size() > 0)
+        newtons_method<double>(function, options, promoted, roots, results);
+}
+
+/// @brief a rectangle of the image, right and bottom are the last column and row in it
+struct imageTile {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+/// @return the image split into tiles of size by size pixels, or smaller at the right and bottom edges, a row of tiles
+/// at a time so the block of tiles each worker starts with covers whole rows of the results and color planes
+std::vector<imageTile> splitIntoTiles(const renderOptions& options, int size) {
+    std::vector<imageTile> tiles;
+    for (int top = 0; top < options.imgheight; top += size)
+        for (int left = 0; left < options.imgwidth; left += size)
+            tiles.push_back({ left, top, std::min(left + size, options.imgwidth) - 1, std::min(top + size, options.imgheight) - 1 });
+    return tiles;
+}
+
+/// @return size of the tiles a render is split into
+int tileSize(const renderOptions& options) {
+    return options.trace ? TRACE_TILE_SIZE : TILE_SIZE;
+}
+
+/// @brief Find the roots for one sample of every pixel in a tile. In mixed precision the tile and a ring of pixels
+/// around it are done in float on a plane of their own, so each pixel is compared with all four next to it, the
+/// ones across the edges of the tile too, without reading tiles that other workers could still be writing
+void newtons_method(func& function, const renderOptions& options, const imageTile& tile, int sample, rootRegistry& roots, framebuffer<pixelResult>& results) {
+    std::vector<pixelPosition> pixels;
+    if (options.precision != PRECISION_MIXED) {
+        pixels.reserve((tile.right - tile.left + 1) * (tile.bottom - tile.top + 1));
+        for (int i = tile.left; i <= tile.right; i++)
+            for (int j = tile.top; j <= tile.bottom; j++)
+                pixels.push_back({ i, j, sample });
+        newtons_method(function, options, pixels, roots, results);
+        return;
+    }
+
+    //the ring is column and row 0 and the last ones of the plane, the tile is inside it
+    renderOptions ring = options;
+    ring.bandLeft = options.bandLeft + tile.left - 1;
+    ring.bandTop = options.bandTop + tile.top - 1;
+    int width = tile.right - tile.left + 3;
+    int height = tile.bottom - tile.top + 3;
+    int imageHeight = options.totalHeight > 0 ? options.totalHeight : options.imgheight;
+    auto inImage = [&](int column, int row) {
+        return column + ring.bandLeft >= 0 && column + ring.bandLeft < options.imgwidth && row + ring.bandTop >= 0 && row + ring.bandTop < imageHeight;
+    };
+    framebuffer<pixelResult> plane(width, height, pixelResult{ NO_ROOT, 0 });
+    for (int i = 0; i < width; i++)
+        for (int j = 0; j < height; j++)
+            if (inImage(i, j))
+                pixels.push_back({ i, j, sample });
+    newtons_method<float>(function, ring, pixels, roots, plane);
+
+    multipleRoots multiple(function, roots);
+    std::vector<pixelPosition> promoted;
+    for (int i = 1; i < width - 1; i++) {
+        for (int j = 1; j < height - 1; j++) {
+            const pixelResult& result = plane(i, j);
+            bool differs = result.root == NO_ROOT || multiple.contains(result.root);
+            const int around[4][2] = { { i - 1, j }, { i + 1, j }, { i, j - 1 }, { i, j + 1 } };
+            for (const auto& n : around)
+                differs = differs || (inImage(n[0], n[1]) && resultsDiffer(result, plane(n[0], n[1])));
+            if (differs)
+                promoted.push_back({ i, j, sample });
         }
     }
+    if (promoted.size() > 0)
+        newtons_method<double>(function, ring, promoted, roots, plane);
+
+    for (int j = 1; j < height - 1; j++)
+        std::copy(plane.row(j) + 1, plane.row(j) + width - 1, &results(tile.left, tile.top + j - 1));
 }
 
+/// @return the workers every render shares, started the first time it is needed
+workerPool& getWorkerPool(const renderOptions& options) {
+    static workerPool pool(options.processor_count, options.affinity);
+    return pool;
+}
+
+/// @brief set the rows of a plane that the image in the options covers, each by the worker that starts with the tiles over it
+template<typename V>
+void fillPlane(const renderOptions& options, framebuffer<V>& plane, V fill) {
+    std::vector<imageTile> tiles = splitIntoTiles(options, tileSize(options));
+    getWorkerPool(options).run(int(tiles.size()), [&](unsigned int, int task) {
+        const imageTile& tile = tiles[task];
+        if (tile.left == 0)
+            plane.fillRows(tile.top, tile.bottom + 1, fill);
+    });
+}
+
+/// @brief make a plane with a value for every pixel. Each row is filled by the worker that starts with the tiles
+/// over it, and memory is placed on the NUMA node of the cpu that first writes to it, so with -affinity the rows
+/// end up next to the worker that renders them instead of all on the node of the main thread
+template<typename V>
+framebuffer<V> makePlane(const renderOptions& options, V fill) {
+    framebuffer<V> plane(options.imgwidth, options.imgheight);
+    fillPlane(options, plane, fill);
+    return plane;
+}
+
+/// @brief Print an error thrown while evaluating a part of the image
+void reportError(int exc) {
+    if (exc == 5) {
+        std::cout << "Evaluation error" << std::endl;
+    }
+    else {
+        std::cout << "Unknown error: " << exc << std::endl;
+    }
+}
+
+/// @brief Mariani-Silver tracing of one tile. Only the border of a tile and a few points inside it are evaluated,
+/// and if every one of them converged to the same root in the same number of steps the inside is filled with that
+/// root and steps. Otherwise the tile is split in half along its longer side
+class tileTracer {
+public:
+    tileTracer(func& function, const renderOptions& options, int sample, const imageTile& tile, rootRegistry& roots, framebuffer<pixelResult>& results)
+        : function(function), options(options), sample(sample), tile(tile), roots(roots), results(results),
+          known(tile.right - tile.left + 1, tile.bottom - tile.top + 1, false) {
+        trace(tile.left, tile.top, tile.right, tile.bottom);
+    }
+
+    //pixels that were iterated instead of filled
+    long long evaluated = 0;
+
+private:
+    func& function;
+    const renderOptions& options;
+    int sample;
+    imageTile tile;
+    rootRegistry& roots;
+    framebuffer<pixelResult>& results;
+    //weather each pixel of the tile has a result for this sample yet, the plane still has the one from the sample before
+    framebuffer<bool> known;
+
+    void add(std::vector<pixelPosition>& pixels, int column, int row) {
+        if (!known(column - tile.left, row - tile.top))
+            pixels.push_back({ column, row, sample });
+    }
+
+    void evaluate(const std::vector<pixelPosition>& pixels) {
+        if (pixels.size() == 0) return;
+        newtons_method(function, options, pixels, roots, results);
+        for (const pixelPosition& p : pixels)
+            known(p.column - tile.left, p.row - tile.top) = true;
+        evaluated += pixels.size();
+    }
+
+    //corners are inclusive
+    void trace(int left, int top, int right, int bottom) {
+        std::vector<pixelPosition> pixels;
+        if (right - left < TRACE_MIN_TILE || bottom - top < TRACE_MIN_TILE) {
+            for (int i = left; i <= right; i++)
+                for (int j = top; j <= bottom; j++)
+                    add(pixels, i, j);
+            evaluate(pixels);
+            return;
+        }
+
+        //go around the border in order so pixels next to each other in the list are next to each other in the image,
+        //which mixed precision checks to find pixels to redo
+        std::vector<pixelPosition> border;
+        for (int i = left; i < right; i++) border.push_back({ i, top });
+        for (int j = top; j < bottom; j++) border.push_back({ right, j });
+        for (int i = right; i > left; i--) border.push_back({ i, bottom });
+        for (int j = bottom; j > top; j--) border.push_back({ left, j });
+        for (const pixelPosition& p : border)
+            add(pixels, p.column, p.row);
+        std::vector<pixelPosition> inside;
+        for (int a = 1; a <= TRACE_CHECKS; a++)
+            for (int b = 1; b <= TRACE_CHECKS; b++)
+                inside.push_back({ left + (right - left) * a / (TRACE_CHECKS + 1), top + (bottom - top) * b / (TRACE_CHECKS + 1) });
+        for (const pixelPosition& p : inside)
+            add(pixels, p.column, p.row);
+        evaluate(pixels);
+
+        //steps are whole numbers, so filling in between different steps on the border would put some pixels in the
+        //wrong band. The inside is only filled when the border and the checks all have the same root and steps
+        pixelResult first = results(left, top);
+        bool uniform = first.root != NO_ROOT;
+        for (const pixelPosition& p : border)
+            uniform = uniform && results(p.column, p.row).root == first.root && results(p.column, p.row).steps == first.steps;
+        for (const pixelPosition& p : inside)
+            uniform = uniform && results(p.column, p.row).root == first.root && results(p.column, p.row).steps == first.steps;
+
+        if (uniform) {
+            for (int i = left + 1; i < right; i++) {
+                for (int j = top + 1; j < bottom; j++) {
+                    if (known(i - tile.left, j - tile.top)) continue;
+                    results(i, j) = first;
+                    known(i - tile.left, j - tile.top) = true;
+                }
+            }
+            return;
+        }
+
+        //both halves share the middle line, which the first one evaluates
+        if (right - left >= bottom - top) {
+            int middle = (left + right) / 2;
+            trace(left, top, middle, bottom);
+            trace(middle, top, right, bottom);
+        }
+        else {
+            int middle = (top + bottom) / 2;
+            trace(left, top, right, middle);
+            trace(left, middle, right, bottom);
+        }
+    }
+};
+
 /// @brief outputs the path taken for a specific starting value of newtons method
 /// @param function referance to function to be evaluated
 void outputpathTaken(func& function){
@@ -191,6 +929,501 @@ void outputpathTaken(func& function){
 
 }
 
+//Color table
+//TODO: make the program read this data from a file that can be user-provided
+const pixel color[] = {
+    pixel("#800000"),
+    pixel("#8B0000"),
+    pixel("#A52A2A"),
+    pixel("#B22222"),
+    pixel("#DC143C"),
+    pixel("#FF0000"),
+    pixel("#FF6347"),
+    pixel("#FF7F50"),
+    pixel("#CD5C5C"),
+    pixel("#F08080"),
+    pixel("#E9967A"),
+    pixel("#FA8072"),
+    pixel("#FFA07A"),
+    pixel("#FF4500"),
+    pixel("#FF8C00"),
+    pixel("#FFA500"),
+    pixel("#FFD700"),
+    pixel("#B8860B"),
+    pixel("#DAA520"),
+    pixel("#EEE8AA"),
+    pixel("#BDB76B"),
+    pixel("#F0E68C"),
+    pixel("#808000"),
+    pixel("#FFFF00"),
+    pixel("#9ACD32"),
+    pixel("#556B2F"),
+    pixel("#6B8E23"),
+    pixel("#7CFC00"),
+    pixel("#ADFF2F"),
+    pixel("#006400"),
+    pixel("#008000"),
+    pixel("#228B22"),
+    pixel("#00FF00"),
+    pixel("#32CD32"),
+    pixel("#90EE90"),
+    pixel("#98FB98"),
+    pixel("#8FBC8F"),
+    pixel("#00FA9A"),
+    pixel("#00FF7F"),
+    pixel("#2E8B57"),
+    pixel("#66CDAA"),
+    pixel("#3CB371"),
+    pixel("#20B2AA"),
+    pixel("#2F4F4F"),
+    pixel("#008080"),
+    pixel("#008B8B"),
+    pixel("#00FFFF"),
+    pixel("#00CED1"),
+    pixel("#40E0D0"),
+    pixel("#48D1CC"),
+    pixel("#AFEEEE"),
+    pixel("#7FFFD4"),
+    pixel("#5F9EA0"),
+    pixel("#4682B4"),
+    pixel("#6495ED"),
+    pixel("#00BFFF"),
+    pixel("#1E90FF"),
+    pixel("#ADD8E6"),
+    pixel("#87CEEB"),
+    pixel("#87CEFA"),
+    pixel("#191970"),
+    pixel("#000080"),
+    pixel("#00008B"),
+    pixel("#0000CD"),
+    pixel("#0000FF"),
+    pixel("#4169E1"),
+    pixel("#8A2BE2"),
+    pixel("#4B0082"),
+    pixel("#483D8B"),
+    pixel("#6A5ACD"),
+    pixel("#7B68EE"),
+    pixel("#9370DB"),
+    pixel("#8B008B"),
+    pixel("#9400D3"),
+    pixel("#9932CC"),
+    pixel("#BA55D3"),
+    pixel("#800080"),
+    pixel("#D8BFD8"),
+    pixel("#DDA0DD"),
+    pixel("#EE82EE"),
+    pixel("#FF00FF"),
+    pixel("#DA70D6"),
+    pixel("#C71585"),
+    pixel("#DB7093"),
+    pixel("#FF1493"),
+    pixel("#FF69B4"),
+    pixel("#FFB6C1"),
+    pixel("#FFC0CB"),
+    pixel("#FFE4C4"),
+    pixel("#F5DEB3"),
+    pixel("#FFFACD"),
+    pixel("#8B4513"),
+    pixel("#A0522D"),
+    pixel("#D2691E"),
+    pixel("#CD853F"),
+    pixel("#F4A460"),
+    pixel("#DEB887"),
+    pixel("#D2B48C"),
+    pixel("#BC8F8F"),
+    pixel("#FFDAB9"),
+    pixel("#FFE4E1"),
+    pixel("#FFEFD5"),
+    pixel("#708090"),
+    pixel("#B0C4DE"),
+    pixel("#E6E6FA"),
+    pixel("#F0FFF0"),
+    pixel("#F0F8FF")
+};
+
+/// @brief colors of every sample of a pixel added up, divided by the number of samples once they are all in
+struct colorSum {
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+};
+
+/// @brief how much work a render took
+struct renderStats {
+    //steps of every sample that found a root
+    long long steps = 0;
+    //samples that didn't find a root
+    long long unconverged = 0;
+    //samples that were iterated instead of filled by tracing
+    long long evaluated = 0;
+    //samples adaptive sampling took after the first of each pixel, and the pixels it took them of
+    long long extraSamples = 0;
+    long long boundaryPixels = 0;
+
+    void add(const renderStats& other) {
+        steps += other.steps;
+        unconverged += other.unconverged;
+        evaluated += other.evaluated;
+        extraSamples += other.extraSamples;
+        boundaryPixels += other.boundaryPixels;
+    }
+};
+
+//the shading is steps * 2 in a byte, so it comes back around to 0 every 128 steps
+constexpr int SHADES = 128;
+
+/// @return every color of the color array with every shade added, by color then shade, so coloring a sample is one
+/// lookup instead of a hash and a clamped add for each channel
+const std::vector<pixel>& shadedColors() {
+    static const std::vector<pixel> table = [] {
+        std::vector<pixel> colors;
+        colors.reserve(sizeof(color) / sizeof(*color) * SHADES);
+        for (const pixel& c : color)
+            for (int shade = 0; shade < SHADES; shade++)
+                colors.push_back(c + pixel(shade * 2));
+        return colors;
+    }();
+    return table;
+}
+
+/// @return color of one sample. A pixel that didn't find a root is black, or grey for a cycle with shorter cycles brighter.
+/// Otherwise picks a color from the color array based on the hash of the root and adds the steps as shading
+/// @param shaded table from shadedColors
+inline pixel sampleColor(const pixelResult& result, const rootRegistry& roots, const renderOptions& options, const pixel* shaded) {
+    if (result.root == NO_ROOT) {
+        int period = result.steps;
+        return options.colorCycles && period > 0 ? pixel(255 / period) : pixel(0);
+    }
+    return shaded[(roots.hash(result.root) % (sizeof(color) / sizeof(*color))) * SHADES + result.steps % SHADES];
+}
+
+/// @brief add the color of one sample of a pixel to the sum for the pixel and count it in stats
+inline void addSample(const pixelResult& result, const rootRegistry& roots, const renderOptions& options, const pixel* shaded, colorSum& sum, renderStats& stats) {
+    pixel p = sampleColor(result, roots, options, shaded);
+    sum.r += p.r;
+    sum.g += p.g;
+    sum.b += p.b;
+    if (result.root == NO_ROOT)
+        stats.unconverged++;
+    else
+        stats.steps += result.steps;
+}
+
+/// @brief add the color of one sample of every pixel of a tile to the sums, a row at a time
+void addSamples(const imageTile& tile, const framebuffer<pixelResult>& results, const rootRegistry& roots, const renderOptions& options, framebuffer<colorSum>& sums, renderStats& stats) {
+    const pixel* shaded = shadedColors().data();
+    for (int j = tile.top; j <= tile.bottom; j++) {
+        const pixelResult* in = results.row(j);
+        colorSum* out = sums.row(j);
+        for (int i = tile.left; i <= tile.right; i++)
+            addSample(in[i], roots, options, shaded, out[i], stats);
+    }
+}
+
+/// @brief write the average of the samples of every pixel of a tile to the image. Dividing is done by multiplying
+/// with the reciprocal so the loop can be vectorized, half a sample is added so a sum that divides exactly doesn't
+/// round down below the right answer, and it is too little to ever round up past it
+void averageSamples(const imageTile& tile, const framebuffer<colorSum>& sums, int samples, const framebufferView<pixel>& image) {
+    double scale = 1.0 / samples;
+    double half = 0.5 / samples;
+    for (int j = tile.top; j <= tile.bottom; j++) {
+        const colorSum* in = sums.row(j);
+        pixel* out = image.row(j);
+        for (int i = tile.left; i <= tile.right; i++) {
+            out[i].r = (unsigned char)(in[i].r * scale + half);
+            out[i].g = (unsigned char)(in[i].g * scale + half);
+            out[i].b = (unsigned char)(in[i].b * scale + half);
+        }
+    }
+}
+
+/// @brief Find the root and number of steps for every pixel of every sample. The image is split into tiles that the
+/// workers take one at a time and do every sample of, so there is no waiting between samples. Each sample of a tile is
+/// colored and added to the sums as soon as it is done, so one plane of results is enough for any number of samples
+/// @param function function object to evaluate, each worker gets its own copy
+/// @param results root and steps of each pixel in the last sample
+/// @param sums colors of every sample of each pixel added up
+/// @param image if it has data, each tile is averaged into it by the worker that rendered it while it's still in cache
+/// @return steps and unconverged samples of the whole render
+renderStats render(func& function, const renderOptions& options, rootRegistry& roots, framebuffer<pixelResult>& results, framebuffer<colorSum>& sums, framebufferView<pixel> image = { nullptr, 0, 0, 0 }) {
+    workerPool& pool = getWorkerPool(options);
+    std::vector<func> functions(pool.size(), function);
+    std::vector<renderStats> stats(pool.size());
+    std::vector<imageTile> tiles = splitIntoTiles(options, tileSize(options));
+    //adaptive sampling starts with one sample of each pixel
+    int passes = options.adaptive ? 1 : options.samples;
+
+    auto work = [&](unsigned int worker, int task) {
+        const imageTile& tile = tiles[task];
+        try {
+            for (int sample = 0; sample < passes; sample++) {
+                if (options.trace) {
+                    tileTracer tracer(functions[worker], options, sample, tile, roots, results);
+                    stats[worker].evaluated += tracer.evaluated;
+                }
+                else {
+                    newtons_method(functions[worker], options, tile, sample, roots, results);
+                    stats[worker].evaluated += (tile.right - tile.left + 1) * (tile.bottom - tile.top + 1);
+                }
+                addSamples(tile, results, roots, options, sums, stats[worker]);
+            }
+            if (image.data != nullptr)
+                averageSamples(tile, sums, passes, image);
+        }
+        catch (int exc) {
+            reportError(exc);
+        }
+    };
+    // [XXXXXXXXXX----------]
+    auto progress = [&]() {
+        if (!options.displayPercent) return;
+        int finished = pool.finished();
+        std::string progressBar = "\r[" ;
+        int i;
+        for (i = 0; i < round(float(finished * progressBarLength) / tiles.size()); i++)
+        {
+            progressBar += "X";
+        }
+        for (; i < progressBarLength; i++)
+        {
+            progressBar += "-";
+        }
+        progressBar += "] ";
+        std::cout << progressBar << finished << "/" << tiles.size() << " tiles";
+    };
+    pool.run(int(tiles.size()), work, progress);
+
+    if(options.displayPercent)
+        std::cout << std::endl;
+    renderStats total;
+    for (const renderStats& s : stats)
+        total.add(s);
+    return total;
+}
+
+/// @brief a pixel on a basin boundary that adaptive sampling takes more samples of
+struct boundaryPixel {
+    pixelPosition position;
+    //root of the first sample, and weather every sample after it found the same one
+    uint16_t firstRoot;
+    bool agree;
+    //samples taken of the pixel so far
+    int samples;
+};
+
+/// @brief Render one sample of every pixel, then keep adding samples to the pixels that are next to a different root
+/// or a jump in steps. A pixel stops getting samples once it has ADAPTIVE_MIN_SAMPLES that all found the same root, or options.samples
+/// @param results gets the first sample of each pixel, then the later samples of the boundary pixels
+/// @param sums colors of the samples each pixel got added up
+/// @param image average of the samples each pixel got
+/// @return steps and unconverged samples of the whole render, and how many extra samples were taken
+renderStats renderAdaptive(func& function, const renderOptions& options, rootRegistry& roots, framebuffer<pixelResult>& results, framebuffer<colorSum>& sums, framebufferView<pixel> image) {
+    renderStats total = render(function, options, roots, results, sums, image);
+
+    std::vector<boundaryPixel> boundary;
+    for (int j = 0; j < options.imgheight; j++) {
+        for (int i = 0; i < options.imgwidth; i++) {
+            bool edge = false;
+            const int neighbours[4][2] = { { i - 1, j }, { i + 1, j }, { i, j - 1 }, { i, j + 1 } };
+            for (const auto& n : neighbours) {
+                if (n[0] < 0 || n[0] >= options.imgwidth || n[1] < 0 || n[1] >= options.imgheight) continue;
+                const pixelResult& a = results(i, j);
+                const pixelResult& b = results(n[0], n[1]);
+                edge = edge || a.root != b.root || std::abs(a.steps - b.steps) > ADAPTIVE_STEP_JUMP;
+            }
+            if (edge) boundary.push_back({ { i, j }, results(i, j).root, true, 1 });
+        }
+    }
+
+    //every pass writes over the results of the pixels in it, which are added to the sums and averaged into the image straight away
+    workerPool& pool = getWorkerPool(options);
+    std::vector<func> functions(pool.size(), function);
+    std::vector<renderStats> stats(pool.size());
+    for (int sample = 1; sample < options.samples; sample++) {
+        std::vector<pixelPosition> pixels;
+        std::vector<int> owner;
+        for (int b = 0; b < boundary.size(); b++) {
+            const boundaryPixel& p = boundary[b];
+            if (sample >= ADAPTIVE_MIN_SAMPLES && p.agree) continue;
+            pixels.push_back({ p.position.column, p.position.row, sample });
+            owner.push_back(b);
+        }
+        if (pixels.size() == 0) break;
+
+        //the pixels are split into tasks of one tile worth of pixels
+        int tasks = int((pixels.size() + TILE_SIZE * TILE_SIZE - 1) / (TILE_SIZE * TILE_SIZE));
+        pool.run(tasks, [&](unsigned int worker, int task) {
+            size_t first = size_t(task) * TILE_SIZE * TILE_SIZE;
+            size_t last = std::min<size_t>(first + TILE_SIZE * TILE_SIZE, pixels.size());
+            std::vector<pixelPosition> part(pixels.begin() + first, pixels.begin() + last);
+            try {
+                newtons_method(functions[worker], options, part, roots, results);
+            }
+            catch (int exc) {
+                reportError(exc);
+            }
+            const pixel* shaded = shadedColors().data();
+            for (size_t p = first; p < last; p++) {
+                int column = pixels[p].column;
+                int row = pixels[p].row;
+                const pixelResult& result = results(column, row);
+                colorSum& sum = sums(column, row);
+                addSample(result, roots, options, shaded, sum, stats[worker]);
+                boundaryPixel& b = boundary[owner[p]];
+                b.agree = b.agree && result.root == b.firstRoot;
+                b.samples++;
+                image(column, row) = pixel(sum.r / b.samples, sum.g / b.samples, sum.b / b.samples);
+            }
+        });
+        total.extraSamples += pixels.size();
+    }
+    for (const renderStats& s : stats)
+        total.add(s);
+    total.boundaryPixels = boundary.size();
+    return total;
+}
+
+/// @brief Print how much of the work tracing and adaptive sampling saved
+void printStats(const renderOptions& options, const renderStats& stats) {
+    long long pixels = (long long)options.imgwidth * options.imgheight;
+    int passes = options.adaptive ? 1 : options.samples;
+    if (options.trace)
+        std::cout << "Tracing evaluated " << 100.0 * stats.evaluated / (pixels * passes) << "% of pixels" << std::endl;
+    if (options.adaptive)
+        std::cout << "Adaptive sampling took " << double(pixels + stats.extraSamples) / pixels << " samples per pixel, "
+            << stats.boundaryPixels << " pixels on boundaries" << std::endl;
+}
+
+/// @brief Render in full and with tile tracing and print how much of the traced image is different, the traced
+/// render is left in results, sums and image
+/// @return stats of the traced render
+renderStats verifyTracing(func& function, renderOptions options, rootRegistry& roots, framebuffer<pixelResult>& results, framebuffer<colorSum>& sums, framebufferView<pixel> image) {
+    options.trace = false;
+    framebuffer<pixelResult> fullResults = makePlane(options, pixelResult{ NO_ROOT, 0 });
+    framebuffer<colorSum> fullSums = makePlane(options, colorSum{ 0, 0, 0 });
+    auto start = std::chrono::steady_clock::now();
+    render(function, options, roots, fullResults, fullSums);
+    double fullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    options.trace = true;
+    start = std::chrono::steady_clock::now();
+    renderStats stats = render(function, options, roots, results, sums, image);
+    double tracedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    //only the last sample is still there to compare, the colors have every sample in them
+    long long differentRoots = 0, differentSteps = 0, largestStepError = 0, differentColors = 0;
+    for (int j = 0; j < options.imgheight; j++) {
+        for (int i = 0; i < options.imgwidth; i++) {
+            differentRoots += fullResults(i, j).root != results(i, j).root;
+            int error = std::abs(fullResults(i, j).steps - results(i, j).steps);
+            differentSteps += error != 0;
+            largestStepError = std::max<long long>(largestStepError, error);
+            const colorSum& a = fullSums(i, j);
+            const colorSum& b = sums(i, j);
+            differentColors += a.r != b.r || a.g != b.g || a.b != b.b;
+        }
+    }
+    long long pixels = (long long)options.imgwidth * options.imgheight;
+    std::cout << "Full render " << fullSeconds << " sec, traced " << tracedSeconds << " sec" << std::endl;
+    std::cout << "Different root: " << 100.0 * differentRoots / pixels << "% of pixels in the last sample, different steps: "
+        << 100.0 * differentSteps / pixels << "% of pixels, largest difference " << largestStepError << " steps" << std::endl;
+    std::cout << "Different color: " << 100.0 * differentColors / pixels << "% of pixels" << std::endl;
+    return stats;
+}
+
+/// @brief Render with each iteration engine and print the average number of steps and time per pixel for each,
+/// so the fastest one for a function can be picked
+void compareEngines(func& function, renderOptions options) {
+    struct candidate {
+        std::string name;
+        iterationEngine engine;
+        int order;
+    };
+    const candidate candidates[] = {
+        { "newton", ENGINE_NEWTON, 1 },
+        { "relaxed newton", ENGINE_RELAXED, 1 },
+        { "halley", ENGINE_HALLEY, 2 },
+        { "householder 3", ENGINE_HOUSEHOLDER, 3 },
+        { "householder 4", ENGINE_HOUSEHOLDER, MAX_TAYLOR_TERMS - 1 },
+    };
+    options.displayPercent = false;
+    long long pixels = (long long)options.imgwidth * options.imgheight * options.samples;
+    std::cout << "engine            steps/pixel   us/pixel   unconverged" << std::endl;
+    for (const candidate& c : candidates) {
+        options.engine = c.engine;
+        options.order = c.order;
+        rootRegistry roots(accuracy * 10);
+        framebuffer<pixelResult> results = makePlane(options, pixelResult{ NO_ROOT, 0 });
+        framebuffer<colorSum> sums = makePlane(options, colorSum{ 0, 0, 0 });
+        auto start = std::chrono::steady_clock::now();
+        renderStats stats = render(function, options, roots, results, sums);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        char line[128];
+        std::snprintf(line, sizeof(line), "%-16s %12.2f %10.3f %12.2f%%", c.name.c_str(), double(stats.steps) / std::max(pixels - stats.unconverged, 1LL),
+            seconds * 1e6 / pixels, 100.0 * stats.unconverged / pixels);
+        std::cout << line << std::endl;
+    }
+}
+
+/// @return rows in each band of a render with -memlimit. Each pixel of a band needs its result, its color sum and two
+/// colors, one for the band being rendered and one for the band being written. A png also needs the filtered band and
+/// the compressed one, which is no bigger. Bands are a whole number of tiles high so they are split into the same tiles
+/// the whole image would be
+int bandHeight(const renderOptions& options) {
+    int colorsPerPixel = options.format == FORMAT_BMP ? 2 : 4;
+    long long bytesPerRow = (long long)options.imgwidth * (sizeof(pixelResult) + sizeof(colorSum) + colorsPerPixel * sizeof(pixel));
+    long long rows = (long long)options.memoryLimit * 1024 * 1024 / std::max(bytesPerRow, 1LL);
+    int size = tileSize(options);
+    rows = std::max<long long>(rows / size * size, size);
+    return int(std::min<long long>(rows, options.imgheight));
+}
+
+/// @brief Render the image in bands of rows and write each band to the file as soon as it is done, so only two bands
+/// are ever in memory. Each band is written on another thread while the workers render the next one
+/// @param bottomUp render the bottom band first, a bmp starts with the bottom row
+/// @param encode gets each band once it is rendered and gives back the job that encodes and writes it, which is run on
+/// the other thread. The band stays in memory until that job is done
+/// @param stats stats of every band added up
+/// @return weather or not every band was written
+bool renderBands(func& function, const renderOptions& options, rootRegistry& roots, bool bottomUp, const std::function<std::function<bool()>(framebufferView<const pixel>)>& encode, renderStats& stats) {
+    int rows = bandHeight(options);
+    int bands = (options.imgheight + rows - 1) / rows;
+    renderOptions band = options;
+    band.totalHeight = options.imgheight;
+    band.imgheight = rows;
+    band.displayPercent = false;
+    framebuffer<pixelResult> results = makePlane(band, pixelResult{ NO_ROOT, 0 });
+    framebuffer<colorSum> sums = makePlane(band, colorSum{ 0, 0, 0 });
+    framebuffer<pixel> images[2] = { makePlane(band, pixel(0)), makePlane(band, pixel(0)) };
+
+    std::future<bool> writing;
+    bool written = true;
+    for (int k = 0; k < bands; k++) {
+        //bands start at whole numbers of bands from the top, so the bottom one can be shorter
+        band.bandTop = (bottomUp ? bands - 1 - k : k) * rows;
+        band.imgheight = std::min(rows, options.imgheight - band.bandTop);
+        if (k > 0)
+            fillPlane(band, sums, colorSum{ 0, 0, 0 });
+        framebufferView<pixel> image = images[k % 2].view(0, 0, options.imgwidth, band.imgheight);
+        stats.add(options.adaptive ? renderAdaptive(function, band, roots, results, sums, image) : render(function, band, roots, results, sums, image));
+        const framebuffer<pixel>& done = images[k % 2];
+        std::function<bool()> write = encode(done.view(0, 0, options.imgwidth, band.imgheight));
+
+        //the band before has to be in the file before this one goes after it
+        if (writing.valid())
+            written = writing.get() && written;
+        writing = std::async(std::launch::async, write);
+        if (options.displayPercent)
+            std::cout << "\r" << k + 1 << "/" << bands << " bands" << std::flush;
+    }
+    if (writing.valid())
+        written = writing.get() && written;
+    if (options.displayPercent)
+        std::cout << std::endl;
+    return written;
+}
+
 int main(int argc, char* argv[]) {
     if (argc == 2 && std::string(argv[1]) == "-help") {
         std::cout << "Newtons Fractal:" << std::endl;
@@ -209,126 +1442,32 @@ int main(int argc, char* argv[]) {
         std::cout << "-nopercent                don't display percent complete              example: -nopercent" << std::endl;
         std::cout << "-showroots                show all/none or default amount of roots    example: -showroots all/none" << std::endl;
         std::cout << "-samplecout or -s         number of samples per pixel                 example: -samplecout 8" << std::endl;
-        std::cout << "-title or -t              change the name of the output bmp file      exampleL -title \"img1.bmp\"" << std::endl;
+        std::cout << "-title or -t              change the name of the output file          exampleL -title \"img1.bmp\"" << std::endl;
+        std::cout << "-jit                      compile the function to native code         example: -jit" << std::endl;
+        std::cout << "-precision                auto, mixed, float, double, dd or qd        example: -precision mixed" << std::endl;
+        std::cout << "-cycles                   color pixels stuck in a cycle by its length example: -cycles" << std::endl;
+        std::cout << "-engine                   newton, relaxed, halley or householder      example: -engine halley" << std::endl;
+        std::cout << "-relaxation               part of each step relaxed newton takes      example: -relaxation 0.5" << std::endl;
+        std::cout << "-order                    order of the householder method, up to " << MAX_TAYLOR_TERMS - 1 << "    example: -order 4" << std::endl;
+        std::cout << "-compare                  time each engine instead of saving an image example: -compare" << std::endl;
+        std::cout << "-tolerance                step size a pixel is done at, 0.4/zoom      example: -tolerance 0.0001" << std::endl;
+        std::cout << "-maxsteps                 steps before a pixel is given up on         example: -maxsteps 200" << std::endl;
+        std::cout << "-affinity                 keep each worker thread on one cpu          example: -affinity" << std::endl;
+        std::cout << "-mmap                     render straight into the file, width%4 == 0 example: -mmap" << std::endl;
+        std::cout << "-format                   bmp, png or palette(indexed png)            example: -format png" << std::endl;
+        std::cout << "-memlimit                 render in bands that fit in this many MB    example: -memlimit 512" << std::endl;
+        std::cout << "-adaptive                 only take more samples on basin boundaries  example: -adaptive -samplecout 16" << std::endl;
+        std::cout << "-trace                    fill even tiles, a few pixels may shade off example: -trace" << std::endl;
+        std::cout << "-verifytrace              compare a traced render to a full one       example: -verifytrace" << std::endl;
         return 0;
     }
 
-    //Color table
-    //TODO: make the program read this data from a file that can be user-provided
-    const pixel color[] = {
-        pixel("#800000"),
-        pixel("#8B0000"),
-        pixel("#A52A2A"),
-        pixel("#B22222"),
-        pixel("#DC143C"),
-        pixel("#FF0000"),
-        pixel("#FF6347"),
-        pixel("#FF7F50"),
-        pixel("#CD5C5C"),
-        pixel("#F08080"),
-        pixel("#E9967A"),
-        pixel("#FA8072"),
-        pixel("#FFA07A"),
-        pixel("#FF4500"),
-        pixel("#FF8C00"),
-        pixel("#FFA500"),
-        pixel("#FFD700"),
-        pixel("#B8860B"),
-        pixel("#DAA520"),
-        pixel("#EEE8AA"),
-        pixel("#BDB76B"),
-        pixel("#F0E68C"),
-        pixel("#808000"),
-        pixel("#FFFF00"),
-        pixel("#9ACD32"),
-        pixel("#556B2F"),
-        pixel("#6B8E23"),
-        pixel("#7CFC00"),
-        pixel("#ADFF2F"),
-        pixel("#006400"),
-        pixel("#008000"),
-        pixel("#228B22"),
-        pixel("#00FF00"),
-        pixel("#32CD32"),
-        pixel("#90EE90"),
-        pixel("#98FB98"),
-        pixel("#8FBC8F"),
-        pixel("#00FA9A"),
-        pixel("#00FF7F"),
-        pixel("#2E8B57"),
-        pixel("#66CDAA"),
-        pixel("#3CB371"),
-        pixel("#20B2AA"),
-        pixel("#2F4F4F"),
-        pixel("#008080"),
-        pixel("#008B8B"),
-        pixel("#00FFFF"),
-        pixel("#00CED1"),
-        pixel("#40E0D0"),
-        pixel("#48D1CC"),
-        pixel("#AFEEEE"),
-        pixel("#7FFFD4"),
-        pixel("#5F9EA0"),
-        pixel("#4682B4"),
-        pixel("#6495ED"),
-        pixel("#00BFFF"),
-        pixel("#1E90FF"),
-        pixel("#ADD8E6"),
-        pixel("#87CEEB"),
-        pixel("#87CEFA"),
-        pixel("#191970"),
-        pixel("#000080"),
-        pixel("#00008B"),
-        pixel("#0000CD"),
-        pixel("#0000FF"),
-        pixel("#4169E1"),
-        pixel("#8A2BE2"),
-        pixel("#4B0082"),
-        pixel("#483D8B"),
-        pixel("#6A5ACD"),
-        pixel("#7B68EE"),
-        pixel("#9370DB"),
-        pixel("#8B008B"),
-        pixel("#9400D3"),
-        pixel("#9932CC"),
-        pixel("#BA55D3"),
-        pixel("#800080"),
-        pixel("#D8BFD8"),
-        pixel("#DDA0DD"),
-        pixel("#EE82EE"),
-        pixel("#FF00FF"),
-        pixel("#DA70D6"),
-        pixel("#C71585"),
-        pixel("#DB7093"),
-        pixel("#FF1493"),
-        pixel("#FF69B4"),
-        pixel("#FFB6C1"),
-        pixel("#FFC0CB"),
-        pixel("#FFE4C4"),
-        pixel("#F5DEB3"),
-        pixel("#FFFACD"),
-        pixel("#8B4513"),
-        pixel("#A0522D"),
-        pixel("#D2691E"),
-        pixel("#CD853F"),
-        pixel("#F4A460"),
-        pixel("#DEB887"),
-        pixel("#D2B48C"),
-        pixel("#BC8F8F"),
-        pixel("#FFDAB9"),
-        pixel("#FFE4E1"),
-        pixel("#FFEFD5"),
-        pixel("#708090"),
-        pixel("#B0C4DE"),
-        pixel("#E6E6FA"),
-        pixel("#F0FFF0"),
-        pixel("#F0F8FF")
-    };
-
     //Initialize default values
     renderOptions options;
 
     func func;
+    bool compare = false;
+    bool verifyTrace = false;
 
     //Argument handling
     if (argc > 1) {
@@ -351,10 +1490,12 @@ int main(int argc, char* argv[]) {
             }
             else if (std::string(argv[i]) == "-reoffset" || std::string(argv[i]) == "-re") {
                 options.offset.re = std::stod(argv[i + 1]);
+                options.preciseOffset.re = parseMultiDouble<4>(argv[i + 1]);
                 i++;
             }
             else if (std::string(argv[i]) == "-imoffset" || std::string(argv[i]) == "-im") {
                 options.offset.im = std::stod(argv[i + 1]);
+                options.preciseOffset.im = parseMultiDouble<4>(argv[i + 1]);
                 i++;
             }
             else if (std::string(argv[i]) == "-zoom" || std::string(argv[i]) == "-z") {
@@ -388,6 +1529,91 @@ int main(int argc, char* argv[]) {
             else if (std::string(argv[i]) == "-nopercent") {
                 options.displayPercent = false;
             }
+            else if (std::string(argv[i]) == "-jit") {
+                options.jit = true;
+            }
+            else if (std::string(argv[i]) == "-cycles") {
+                options.colorCycles = true;
+            }
+            else if (std::string(argv[i]) == "-engine") {
+                std::string name = argv[i + 1];
+                if (name == "newton") options.engine = ENGINE_NEWTON;
+                else if (name == "relaxed") options.engine = ENGINE_RELAXED;
+                else if (name == "halley") options.engine = ENGINE_HALLEY;
+                else if (name == "householder") options.engine = ENGINE_HOUSEHOLDER;
+                i++;
+            }
+            else if (std::string(argv[i]) == "-relaxation") {
+                options.relaxation = std::stod(argv[i + 1]);
+                i++;
+            }
+            else if (std::string(argv[i]) == "-order") {
+                options.order = std::min(std::max(std::stoi(argv[i + 1]), 1), MAX_TAYLOR_TERMS - 1);
+                i++;
+            }
+            else if (std::string(argv[i]) == "-tolerance") {
+                options.tolerance = std::stod(argv[i + 1]);
+                i++;
+            }
+            else if (std::string(argv[i]) == "-maxsteps") {
+                options.maxSteps = std::min(std::max(std::stoi(argv[i + 1]), 2), MAX_STEPS_LIMIT);
+                i++;
+            }
+            else if (std::string(argv[i]) == "-affinity") {
+                options.affinity = true;
+            }
+            else if (std::string(argv[i]) == "-mmap") {
+                options.mapFile = true;
+            }
+            else if (std::string(argv[i]) == "-memlimit") {
+                options.memoryLimit = std::max(std::stoi(argv[i + 1]), 1);
+                i++;
+            }
+            else if (std::string(argv[i]) == "-adaptive") {
+                options.adaptive = true;
+            }
+            else if (std::string(argv[i]) == "-trace") {
+                options.trace = true;
+            }
+            else if (std::string(argv[i]) == "-verifytrace") {
+                verifyTrace = true;
+            }
+            else if (std::string(argv[i]) == "-compare") {
+                compare = true;
+            }
+            else if (std::string(argv[i]) == "-precision") {
+                if (std::string(argv[i + 1]) == "dd") {
+                    options.precision = PRECISION_DOUBLE_DOUBLE;
+                    i++;
+                }else if (std::string(argv[i + 1]) == "qd") {
+                    options.precision = PRECISION_QUAD_DOUBLE;
+                    i++;
+                }else if (argv[i + 1][0] == 'f' || argv[i + 1][0] == 'F') {
+                    options.precision = PRECISION_FLOAT;
+                    i++;
+                }else if (argv[i + 1][0] == 'd' || argv[i + 1][0] == 'D') {
+                    options.precision = PRECISION_DOUBLE;
+                    i++;
+                }else if (argv[i + 1][0] == 'a' || argv[i + 1][0] == 'A') {
+                    options.precision = PRECISION_AUTO;
+                    i++;
+                }else if (argv[i + 1][0] == 'm' || argv[i + 1][0] == 'M') {
+                    options.precision = PRECISION_MIXED;
+                    i++;
+                }
+            }
+            else if (std::string(argv[i]) == "-format") {
+                if (std::string(argv[i + 1]) == "bmp") {
+                    options.format = FORMAT_BMP;
+                    i++;
+                }else if (std::string(argv[i + 1]) == "png") {
+                    options.format = FORMAT_PNG;
+                    i++;
+                }else if (std::string(argv[i + 1]) == "palette") {
+                    options.format = FORMAT_PNG_PALETTE;
+                    i++;
+                }
+            }
             else if (std::string(argv[i]) == "-showroots") {
                 if (argv[i + 1][0] == 'a' || argv[i + 1][0] == 'A') {
                     options.showRoots = ALL;
@@ -431,119 +1657,141 @@ int main(int argc, char* argv[]) {
     if (options.samples == 0) {
         options.samples = getInput<int>("Samples: ");
     }
+    if (isnanIEEE754(options.tolerance)) {
+        options.tolerance = defaultTolerance(options);
+    }
+    //offsets that didn't come from the command line are only as precise as a double
+    if (isnanIEEE754(options.preciseOffset.re.limb[0])) {
+        options.preciseOffset.re = options.offset.re;
+    }
+    if (isnanIEEE754(options.preciseOffset.im.limb[0])) {
+        options.preciseOffset.im = options.offset.im;
+    }
     if (options.functionString != "") {
         func.init(options.functionString);
     }else{
         func.init();
     }
+    func.kernel = find_kernel(func);
+    if (func.kernel == nullptr && options.jit) {
+        func.kernel = compile_kernel(func);
+    }
+    //auto is double unless the zoom needs more. Mixed only starts in float when float can tell the pixels apart, and
+    //a native kernel in double is faster than interpreting in float. Kernels only do newton steps, so only newton
+    //and relaxed newton use them. Auto doesn't use mixed since promoting every pixel that float could get wrong
+    //leaves it slower than double for most functions
+    if (options.precision == PRECISION_AUTO || options.precision == PRECISION_MIXED) {
+        if (!precisionIsEnough<double>(options))
+            options.precision = precisionIsEnough<doubleDouble>(options) ? PRECISION_DOUBLE_DOUBLE : PRECISION_QUAD_DOUBLE;
+        else if (options.precision == PRECISION_AUTO || (func.kernel != nullptr && engineOrder(options) == 1) || !precisionIsEnough<float>(options))
+            options.precision = PRECISION_DOUBLE;
+    }
+    if (options.precision == PRECISION_DOUBLE_DOUBLE)
+        std::cout << "Using double-double precision" << std::endl;
+    if (options.precision == PRECISION_QUAD_DOUBLE)
+        std::cout << "Using quad-double precision" << std::endl;
+
+    if (compare) {
+        compareEngines(func, options);
+        return 0;
+    }
     
+    //Replances / and * with _ for filename
+    for (int i = 0; i < func.function_string.length();i++) {
+        if (func.function_string[i] == '/') func.function_string[i] = '~';
+        else if (func.function_string[i] == '*') func.function_string[i] = 'X';
+    }
+    if(options.title == "")
+        options.title = func.function_string;
+    bmp bmp(options.title + ".bmp");
+    png png(options.title + ".png");
+    if (options.format == FORMAT_PNG_PALETTE && options.memoryLimit > 0) {
+        //the colors have to be known before the first band is written
+        std::cout << "A png with a palette needs the whole image in memory, saving it as rgb" << std::endl;
+        options.format = FORMAT_PNG;
+    }
+    if (options.format == FORMAT_BMP && !bmp::fits(options.imgwidth, options.imgheight)) {
+        //the sizes in a bmp header are 32 bits, so it can't be more than about 4GB
+        std::cout << "The image is too big for a bmp file, save it as a png with -format png" << std::endl;
+        return 1;
+    }
+    if (options.format != FORMAT_BMP && options.mapFile) {
+        std::cout << "-mmap only works for bmp files" << std::endl;
+        options.mapFile = false;
+    }
+
     //Start program timer
     clock_t start, end;
     start = clock();
 
-    //Initialize scale, offset, root table, and shading table
-    double scale = 1/options.zoom;
+    //Initialize offset, root registry, results and color sums
     complex offset = complex(options.offset.re, -options.offset.im);
-    std::vector<std::vector<std::vector<complex>>> valuesTable(options.samples, std::vector<std::vector<complex>>(options.imgwidth, std::vector<complex>(options.imgheight, complex(NAN))));
-    std::vector<std::vector<short>> shading(options.imgwidth, std::vector<short>(options.imgheight, 0));
-    unsigned int progressCounter = 0;
-
-    std::vector<std::future<void>> thread(options.processor_count);
-    std::vector<std::future_status> status(options.processor_count);
-    for( int sample = 0; sample < options.samples; sample++){
-        for (int i = 0; i < options.processor_count; i++)
-        {
-            int startcol = round(float(i) * (float(options.imgwidth) / float(options.processor_count)));
-            int endcol = round((float(i) + 1.0) * (float(options.imgwidth) / float(options.processor_count)));
-            auto randOffset = complex((double(rand()) / RAND_MAX) - 0.5, (double(rand()) / RAND_MAX) - 0.5) * scale;
-            renderOptions sectionOptions = options;
-            sectionOptions.offset = sectionOptions.offset + randOffset;
-            thread[i] = std::async(std::launch::async, evalSection, sectionOptions, i, func, std::ref(valuesTable[sample]), std::ref(shading), std::ref(progressCounter));
-        }
-        while(true){
-            int total = 0;
-            for(int i = 0; i < options.processor_count; i++)
-                total += int(thread[i].wait_for(std::chrono::milliseconds(100)));
-            if(total == 0)
-                break;
-            // [XXXXXXXXXX----------]
-            if (options.displayPercent) {
-                std::string progressBar = "\r[" ;
-                int i;
-                for (i = 0; i < round(((float(progressCounter * progressBarLength) / options.imgwidth) / options.samples)); i++)
-                {
-                    progressBar += "X";
-                }
-                for (; i < progressBarLength; i++)
-                {
-                    progressBar += "-";
-                }
-                progressBar += "] ";
-                std::cout << progressBar << progressCounter << "/" << options.imgwidth * options.samples;
-            }
+    rootRegistry registry(accuracy * 10);
+    renderStats stats;
+    imgdata image;
+    bool mapped = false;
+    bool saved = false;
+    //with -memlimit the image is rendered a band at a time and each band is written to the file as soon as it is done
+    bool streamed = options.memoryLimit > 0 && !verifyTrace;
+    if (streamed) {
+        std::cout << "Rendering in bands of " << bandHeight(options) << " rows" << std::endl;
+        if (options.format == FORMAT_BMP) {
+            saved = bmp.begin(options.imgwidth, options.imgheight) && renderBands(func, options, registry, true, [&](framebufferView<const pixel> rows) {
+                return std::function<bool()>([&bmp, rows]() { return bmp.writeRows(rows); });
+            }, stats);
+            saved = bmp.finish() && saved;
+        }
+        else {
+            //a band is compressed on the writer thread while the next one renders. The render workers are busy with that
+            //band, so the writer has workers of its own that share the cpus with them
+            workerPool encoders(options.processor_count);
+            saved = png.begin(options.imgwidth, options.imgheight) && renderBands(func, options, registry, false, [&](framebufferView<const pixel> rows) {
+                return std::function<bool()>([&png, &encoders, rows]() { return png.writeEncoded(png.encodeRows(rows, encoders)); });
+            }, stats);
+            saved = png.finish() && saved;
         }
-        for (int i = 0; i < options.processor_count; i++)
-            thread[i].get();
-        
     }
-    if(options.displayPercent)
-        std::cout << std::endl;
-    
-    std::cout << "Generating image..." << std::endl;
-    std::vector<imgdata> imgdataTable(options.samples, imgdata(options.imgwidth, options.imgheight));
-
-
-    //Loop through every pixel
-    for (int i = 0; i < options.imgwidth; i++)
-    {
-        for (int j = 0; j < options.imgheight; j++)
-        {
-            for(int k = 0; k < options.samples; k++){
-                //If NAN is found, set the pixel color to be black
-                if (isnanIEEE754(valuesTable[k][i][j])) {
-                    imgdataTable[k].data[i][j] = pixel(0);
-                    continue;
-                }
-                
-                //Picks a color from the color array based on the roots hash and adds shading value
-                valuesTable[k][i][j] = complex(round(valuesTable[k][i][j].re/(accuracy*10))*(accuracy*10),round(valuesTable[k][i][j].im/(accuracy*10))*(accuracy*10));
-                auto hash = simpleHash(valuesTable[k][i][j]);
-                imgdataTable[k].data[i][j] = color[hash % (sizeof(color) / sizeof(*color))] + pixel(shading[i][j] * 2 / options.samples);
-            }
-            //average the samples
-            int r = 0;
-            int g = 0;
-            int b = 0;
-            for( int sample = 0; sample < options.samples; sample++){
-                r += imgdataTable[sample].data[i][j].r;
-                g += imgdataTable[sample].data[i][j].g;
-                b += imgdataTable[sample].data[i][j].b;
-            }
-            imgdataTable[0].data[i][j].r = r / options.samples;
-            imgdataTable[0].data[i][j].g = g / options.samples;
-            imgdataTable[0].data[i][j].b = b / options.samples;
+    else {
+        //one plane of results is used for every sample, each sample is added to the color sums as soon as it is done
+        //and the workers average each tile into the image once it has all of its samples
+        framebuffer<pixelResult> results = makePlane(options, pixelResult{ NO_ROOT, 0 });
+        framebuffer<colorSum> sums = makePlane(options, colorSum{ 0, 0, 0 });
+        //with -mmap the workers write the image straight into the file, otherwise it is kept in memory until it is saved
+        framebufferView<pixel> target = { nullptr, 0, 0, 0 };
+        if (options.mapFile) {
+            target = bmp.map(options.imgwidth, options.imgheight);
+            if (target.data == nullptr)
+                std::cout << "Couldn't map the file, the width has to be a multiple of 4" << std::endl;
+        }
+        mapped = target.data != nullptr;
+        if (!mapped) {
+            image.width = options.imgwidth;
+            image.height = options.imgheight;
+            image.data = makePlane(options, pixel(0));
+            target = image.data.view();
         }
+        if (options.adaptive)
+            stats = renderAdaptive(func, options, registry, results, sums, target);
+        else if (verifyTrace)
+            stats = verifyTracing(func, options, registry, results, sums, target);
+        else
+            stats = render(func, options, registry, results, sums, target);
     }
+    printStats(options, stats);
+
+    std::cout << "Generating image..." << std::endl;
     if(options.showRoots != NONE){
-        std::set<complex> roots;
-        for(std::vector<complex> rows : valuesTable[0]){
-            for(complex value : rows){
-                if(!isnanIEEE754(value))
-                    roots.insert(value);
-            }
-        }
-        if(options.showRoots == ALL)
+        //every ID is a different root, sorted so the list is the same whichever order the workers found them in
+        std::vector<complex> roots;
+        for (int id = 0; id < registry.size(); id++)
+            roots.push_back(roundedRoot(registry.root(id)));
+        std::sort(roots.begin(), roots.end());
+        //Outputs every root if there are less than 10 or all are asked for, otherwise output number of roots
+        if (options.showRoots == DEFAULT && roots.size() > 10)
+            std::cout << "found " << roots.size() << " roots" << std::endl;
+        else
             for (complex root : roots)
-                std::cout << "fount root :" << string(root) << std::endl;
-        else{ //showRoots == DEFAULT
-            //Outputs every root if there are less than 10, otherwise output number of roots
-            if (roots.size() > 10) 
-                std::cout << "found " << roots.size() << " roots" << std::endl;
-            else
-                for (complex root : roots)
-                    std::cout << "fount root :" << string(root) << std::endl;
-        }
-        
+                std::cout << "found root: " << string(root) << std::endl;
     }
     
     //End timer and output program time
@@ -553,18 +1801,20 @@ int main(int argc, char* argv[]) {
     
 
 
-    //Replances / and * with _ for filename
-    for (int i = 0; i < func.function_string.length();i++) {
-        if (func.function_string[i] == '/') func.function_string[i] = '~';
-        else if (func.function_string[i] == '*') func.function_string[i] = 'X';
-    }
-
     //Write image data to file
-    if(options.title == "")
-        options.title = func.function_string;
-    bmp bmp(options.title + ".bmp");
-    if(bmp.writeFile(imgdataTable[0])) 
-        std::cout << "Saved file as: " << bmp.filename << std::endl;
+    std::string filename = options.format == FORMAT_BMP ? bmp.filename : png.filename;
+    if (!streamed && options.format != FORMAT_BMP) {
+        const framebuffer<pixel>& pixels = image.data;
+        std::vector<pixel> palette;
+        if (options.format == FORMAT_PNG_PALETTE && !png::findPalette(pixels.view(), getWorkerPool(options), palette))
+            std::cout << "The image has more than 256 colors, saving it as rgb" << std::endl;
+        saved = png.writeFile(pixels.view(), getWorkerPool(options), palette);
+    }
+    else if (!streamed) {
+        saved = mapped ? bmp.unmap() : bmp.writeFile(image);
+    }
+    if(saved) 
+        std::cout << "Saved file as: " << filename << std::endl;
     else 
         std::cout << "Error saving file." << std::endl;
 
@@ -575,7 +1825,7 @@ int main(int argc, char* argv[]) {
 
     //Open the file
     if (options.openOnFinish)  
-        system(("\"\"./images/" + bmp.filename + "\"\"").c_str());
+        system(("\"\"./images/" + filename + "\"\"").c_str());
     #endif
     
     return 0;
@@ -586,5 +1836,4 @@ int main(int argc, char* argv[]) {
 TODO:
 add gui
 add support for the user to add color pallettes
-figure out how to make a png instead of bmp
 */
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "mapping.hpp"
+#ifdef _WIN32
+//only the file and mapping calls are needed, without the min and max macros
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/// @brief Make the file, or empty it if it is already there, at its full size and map all of it
+/// @return the bytes of the file, or nullptr if it couldn't be made or mapped
+char* mappedFile::open(const std::string& path, uint64_t _size) {
+	if (data != nullptr || _size == 0) return nullptr;
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+	HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READWRITE, DWORD(_size >> 32), DWORD(_size), nullptr);
+	void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, SIZE_T(_size)) : nullptr;
+	if (view == nullptr) {
+		if (mapping != nullptr) CloseHandle(mapping);
+		CloseHandle(handle);
+		return nullptr;
+	}
+	fileHandle = handle;
+	mappingHandle = mapping;
+#else
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1)
+		return nullptr;
+	void* view = ftruncate(fd, off_t(_size)) == 0 ? mmap(nullptr, std::size_t(_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	if (view == MAP_FAILED) {
+		::close(fd);
+		return nullptr;
+	}
+	descriptor = fd;
+#endif
+	data = (char*)view;
+	size = _size;
+	return data;
+}
+
+/// @brief Unmap the file, which finishes writing it
+/// @return weather or not the file was saved sucessfully
+bool mappedFile::close() {
+	if (data == nullptr) return false;
+#ifdef _WIN32
+	bool saved = FlushViewOfFile(data, 0) != 0;
+	saved = UnmapViewOfFile(data) != 0 && saved;
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	bool saved = munmap(data, std::size_t(size)) == 0;
+	saved = ::close(descriptor) == 0 && saved;
+	descriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+	return saved;
+}
+
+mappedFile::~mappedFile()
+{
+	close();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// @brief A file made at a set size and mapped into memory so it can be written straight into. The platform's
+/// mapping calls and headers stay in mapping.cpp so the macros windows.h defines don't reach other files
+class mappedFile
+{
+public:
+	~mappedFile();
+	char* open(const std::string& path, uint64_t _size);
+	bool close();
+private:
+	char* data = nullptr;
+	uint64_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int descriptor = -1;
+#endif
+};
@@ -0,0 +1,268 @@
+#include "png.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include "deflate.hpp"
+
+//about this many bytes of filtered rows are compressed as one piece by one worker. Smaller pieces spread over more
+//workers but every piece starts its huffman codes over and ends with a sync flush
+constexpr int PIECE_SIZE = 1 << 18;
+
+//rows each worker looks through at a time for the colors of an indexed image
+constexpr int PALETTE_ROWS = 64;
+
+//the most colors an indexed png can have
+constexpr std::size_t MAX_PALETTE = 256;
+
+static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static inline uint32_t colorKey(const pixel& p) {
+	return uint32_t(p.r) << 16 | uint32_t(p.g) << 8 | p.b;
+}
+
+static void writeBigEndian(unsigned char* out, uint32_t value) {
+	out[0] = (unsigned char)(value >> 24);
+	out[1] = (unsigned char)(value >> 16);
+	out[2] = (unsigned char)(value >> 8);
+	out[3] = (unsigned char)value;
+}
+
+/// @return the paeth predictor, whichever of the left, up and up left bytes is closest to left + up - up left
+static inline int paeth(int a, int b, int c) {
+	int p = a + b - c;
+	int pa = std::abs(p - a);
+	int pb = std::abs(p - b);
+	int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
+
+/// @brief Filter one row with each of the 5 png filters and keep the one with the smallest sum of bytes taken as
+/// signed, which is the usual guess at what compresses best
+/// @param row bytes of the row, prior bytes of the row above, both size bytes
+/// @param bpp bytes per pixel, how far back the left byte is
+/// @param out the filter type then size filtered bytes
+/// @param scratch room for size bytes
+static void filterRow(const unsigned char* row, const unsigned char* prior, int size, int bpp, unsigned char* out, std::vector<unsigned char>& scratch) {
+	long bestSum = -1;
+	for (int type = 0; type < 5; type++) {
+		long sum = 0;
+		for (int i = 0; i < size; i++) {
+			int a = i >= bpp ? row[i - bpp] : 0;
+			int b = prior[i];
+			int c = i >= bpp ? prior[i - bpp] : 0;
+			int predicted = type == 0 ? 0 : type == 1 ? a : type == 2 ? b : type == 3 ? (a + b) / 2 : paeth(a, b, c);
+			unsigned char f = (unsigned char)(row[i] - predicted);
+			scratch[i] = f;
+			sum += f < 128 ? f : 256 - f;
+		}
+		if (bestSum < 0 || sum < bestSum) {
+			bestSum = sum;
+			out[0] = (unsigned char)type;
+			std::copy(scratch.begin(), scratch.begin() + size, out + 1);
+		}
+	}
+}
+
+/// @brief Find the colors of an image, a band of rows on each worker
+/// @param palette gets every color in the image, sorted
+/// @return weather or not there are few enough for an indexed png
+bool png::findPalette(framebufferView<const pixel> image, workerPool& pool, std::vector<pixel>& palette) {
+	std::unordered_set<uint32_t> colors;
+	std::mutex lock;
+	std::atomic<bool> tooMany{ false };
+	int bands = (image.height + PALETTE_ROWS - 1) / PALETTE_ROWS;
+	pool.run(bands, [&](unsigned int, int task) {
+		std::unordered_set<uint32_t> found;
+		int end = std::min((task + 1) * PALETTE_ROWS, image.height);
+		for (int j = task * PALETTE_ROWS; j < end && !tooMany.load(std::memory_order_relaxed); j++) {
+			const pixel* row = image.row(j);
+			for (int i = 0; i < image.width; i++)
+				found.insert(colorKey(row[i]));
+			if (found.size() > MAX_PALETTE)
+				tooMany = true;
+		}
+		std::lock_guard<std::mutex> guard(lock);
+		colors.insert(found.begin(), found.end());
+		if (colors.size() > MAX_PALETTE)
+			tooMany = true;
+	});
+	if (tooMany)
+		return false;
+	std::vector<uint32_t> keys(colors.begin(), colors.end());
+	std::sort(keys.begin(), keys.end());
+	palette.clear();
+	for (uint32_t key : keys)
+		palette.push_back(pixel(key >> 16, (key >> 8) & 0xFF, key & 0xFF));
+	return true;
+}
+
+/// @brief Write an image to the file
+/// @param image rgb values for each pixel, top row first
+/// @param pool workers that filter and compress the rows
+/// @param palette colors of an indexed image from findPalette, or empty to save rgb
+/// @return weather or not the file was saved sucessfully
+bool png::writeFile(framebufferView<const pixel> image, workerPool& pool, const std::vector<pixel>& _palette) {
+	bool written = begin(image.width, image.height, _palette) && writeEncoded(encodeRows(image, pool));
+	return finish() && written;
+}
+
+/// @brief Open the file and write the headers for an image, the rows are then added with encodeRows and writeEncoded
+/// @param _palette colors of an indexed image, every pixel has to be one of them, or empty for rgb
+/// @return weather or not the file could be opened
+bool png::begin(int _width, int _height, const std::vector<pixel>& _palette) {
+	width = _width;
+	height = _height;
+	palette = _palette;
+	index.clear();
+	for (std::size_t i = 0; i < palette.size(); i++)
+		index[colorKey(palette[i])] = (unsigned char)i;
+	rowBytes = 1 + width * (palette.empty() ? 3 : 1);
+	previousRow.assign(rowBytes - 1, 0);
+	history.clear();
+	adler = 1;
+	rowsEncoded = 0;
+
+	file.open("./images/" + filename, std::fstream::binary);
+	if (!file) return false;
+	std::vector<char> header(signature, signature + 8);
+	unsigned char ihdr[13];
+	writeBigEndian(ihdr, width);
+	writeBigEndian(ihdr + 4, height);
+	ihdr[8] = 8;								//bits per channel, or per index
+	ihdr[9] = palette.empty() ? 2 : 3;			//color type, rgb or indexed
+	ihdr[10] = 0;								//compression, deflate
+	ihdr[11] = 0;								//filter method, per row filters
+	ihdr[12] = 0;								//no interlacing
+	writeChunk(header, "IHDR", ihdr, sizeof(ihdr));
+	if (!palette.empty()) {
+		std::vector<unsigned char> plte;
+		for (const pixel& p : palette)
+			plte.insert(plte.end(), { p.r, p.g, p.b });
+		writeChunk(header, "PLTE", plte.data(), plte.size());
+	}
+	return writeEncoded(header);
+}
+
+/// @brief Filter and compress the next rows of the image. The rows are split into pieces that are filtered and then
+/// compressed on the workers, each into its own IDAT chunk, like pigz. Each piece can match the 32KB before it so
+/// little is lost to splitting. Rows have to be encoded top row first, and the chunks written in the same order
+/// @param rows rgb values for each pixel of the next rows of the image, top row first
+/// @return the IDAT chunks for the rows
+std::vector<char> png::encodeRows(framebufferView<const pixel> rows, workerPool& pool) {
+	int rowsPerPiece = std::max(PIECE_SIZE / rowBytes, 1);
+	int pieces = (rows.height + rowsPerPiece - 1) / rowsPerPiece;
+	bool last = rowsEncoded + rows.height >= height;
+	//the end of the rows encoded before goes in front so the first piece can match it
+	std::size_t start = history.size();
+	std::vector<unsigned char> filtered(start + std::size_t(rows.height) * rowBytes);
+	std::copy(history.begin(), history.end(), filtered.begin());
+
+	int bpp = palette.empty() ? 3 : 1;
+	pool.run(pieces, [&](unsigned int, int task) {
+		int first = task * rowsPerPiece;
+		int end = std::min(first + rowsPerPiece, rows.height);
+		std::vector<unsigned char> prior(rowBytes - 1), current(rowBytes - 1), scratch(rowBytes - 1);
+		if (first == 0)
+			prior = previousRow;
+		else
+			rowBytesOf(rows.row(first - 1), prior.data());
+		for (int j = first; j < end; j++) {
+			rowBytesOf(rows.row(j), current.data());
+			unsigned char* out = filtered.data() + start + std::size_t(j) * rowBytes;
+			//the spec suggests no filter for indexed images, the indices aren't values that can be predicted
+			if (palette.empty()) {
+				filterRow(current.data(), prior.data(), rowBytes - 1, bpp, out, scratch);
+			}
+			else {
+				out[0] = 0;
+				std::copy(current.begin(), current.end(), out + 1);
+			}
+			std::swap(prior, current);
+		}
+	});
+
+	std::vector<std::vector<char>> chunks(pieces);
+	std::vector<uint32_t> checksums(pieces);
+	bool firstPiece = rowsEncoded == 0;
+	pool.run(pieces, [&](unsigned int, int task) {
+		std::size_t offset = start + std::size_t(task) * rowsPerPiece * rowBytes;
+		std::size_t size = std::size_t(std::min(rowsPerPiece, rows.height - task * rowsPerPiece)) * rowBytes;
+		std::vector<unsigned char> data;
+		if (firstPiece && task == 0)
+			data = { 0x78, 0x01 };				//zlib header, deflate with a 32KB window
+		std::vector<unsigned char> compressed = deflatePiece(filtered.data() + offset, size, std::min(offset, DEFLATE_WINDOW), last && task == pieces - 1);
+		data.insert(data.end(), compressed.begin(), compressed.end());
+		checksums[task] = adler32(filtered.data() + offset, size);
+		writeChunk(chunks[task], "IDAT", data.data(), data.size());
+	});
+
+	std::vector<char> out;
+	for (int task = 0; task < pieces; task++) {
+		std::size_t size = std::size_t(std::min(rowsPerPiece, rows.height - task * rowsPerPiece)) * rowBytes;
+		adler = adler32Combine(adler, checksums[task], size);
+		out.insert(out.end(), chunks[task].begin(), chunks[task].end());
+	}
+	if (rows.height > 0)
+		rowBytesOf(rows.row(rows.height - 1), previousRow.data());
+	std::size_t kept = std::min(filtered.size(), DEFLATE_WINDOW);
+	history.assign(filtered.end() - kept, filtered.end());
+	rowsEncoded += rows.height;
+	return out;
+}
+
+/// @brief Add chunks from encodeRows to the file
+/// @return weather or not they were written
+bool png::writeEncoded(const std::vector<char>& chunks) {
+	file.write(chunks.data(), chunks.size());
+	return !file.fail();
+}
+
+/// @brief End the compressed data and the file once every row is written
+/// @return weather or not the file was saved sucessfully
+bool png::finish() {
+	if (!file.is_open()) return false;
+	std::vector<char> end;
+	unsigned char checksum[4];
+	writeBigEndian(checksum, adler);
+	writeChunk(end, "IDAT", checksum, sizeof(checksum));
+	writeChunk(end, "IEND", nullptr, 0);
+	bool written = writeEncoded(end) && rowsEncoded == height;
+	file.close();
+	return !file.fail() && written;
+}
+
+/// @brief Add a chunk, its size, type, data and crc
+void png::writeChunk(std::vector<char>& out, const char* type, const unsigned char* data, std::size_t size) {
+	std::vector<unsigned char> chunk(8 + size + 4);
+	writeBigEndian(chunk.data(), uint32_t(size));
+	std::copy(type, type + 4, chunk.begin() + 4);
+	if (size > 0)
+		std::copy(data, data + size, chunk.begin() + 8);
+	writeBigEndian(chunk.data() + 8 + size, crc32(chunk.data() + 4, 4 + size));
+	out.insert(out.end(), chunk.begin(), chunk.end());
+}
+
+/// @brief The bytes of a row before filtering, rgb or the index of each color in the palette
+void png::rowBytesOf(const pixel* row, unsigned char* out) const {
+	if (palette.empty()) {
+		for (int i = 0; i < width; i++) {
+			out[3 * i] = row[i].r;
+			out[3 * i + 1] = row[i].g;
+			out[3 * i + 2] = row[i].b;
+		}
+	}
+	else {
+		for (int i = 0; i < width; i++)
+			out[i] = index.at(colorKey(row[i]));
+	}
+}
+
+png::png(std::string _filename)
+{
+	filename = _filename;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bmp.hpp"
+#include "framebuffer.hpp"
+#include "scheduler.hpp"
+
+class png
+{
+public:
+	png(std::string _filename);
+	std::string filename;
+	bool writeFile(framebufferView<const pixel> image, workerPool& pool, const std::vector<pixel>& _palette = {});
+	bool begin(int _width, int _height, const std::vector<pixel>& _palette = {});
+	std::vector<char> encodeRows(framebufferView<const pixel> rows, workerPool& pool);
+	bool writeEncoded(const std::vector<char>& chunks);
+	bool finish();
+	static bool findPalette(framebufferView<const pixel> image, workerPool& pool, std::vector<pixel>& palette);
+private:
+	std::ofstream file;
+	int width, height;
+	//colors of an indexed image, empty for rgb
+	std::vector<pixel> palette;
+	//index in the palette of each color, by its rgb as one number
+	std::unordered_map<uint32_t, unsigned char> index;
+	//bytes of each row in the image data, the filter type then the pixels
+	int rowBytes;
+	//the last row encoded before filtering, and the end of the filtered data, which the next rows are compressed after
+	std::vector<unsigned char> previousRow;
+	std::vector<unsigned char> history;
+	//adler-32 of the filtered data so far, which ends the compressed data
+	uint32_t adler;
+	int rowsEncoded;
+
+	void writeChunk(std::vector<char>& out, const char* type, const unsigned char* data, std::size_t size);
+	void rowBytesOf(const pixel* row, unsigned char* out) const;
+};
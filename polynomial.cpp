@@ -0,0 +1,104 @@
+#include <algorithm>
+#include "polynomial.hpp"
+
+polynomial::polynomial(complex constant) {
+    coefficients.push_back(constant);
+}
+
+int polynomial::degree() {
+    return coefficients.size() - 1;
+}
+
+/// @brief evaluate the polynomial using Horner's method
+complex polynomial::evaluate(complex x) {
+    complex value = coefficients.back();
+    for (int k = coefficients.size() - 2; k >= 0; k--) {
+        value = value * x + coefficients[k];
+    }
+    return value;
+}
+
+/// @brief evaluate the polynomial and its derivative together using Horner's method
+void polynomial::evaluate(complex x, complex& value, complex& derivative) {
+    value = coefficients.back();
+    derivative = 0;
+    for (int k = coefficients.size() - 2; k >= 0; k--) {
+        derivative = derivative * x + value;
+        value = value * x + coefficients[k];
+    }
+}
+
+/// @brief remove leading coefficients that are exactly 0 so the degree is correct
+void trim(polynomial& p) {
+    while (p.coefficients.size() > 1 && p.coefficients.back() == complex(0)) {
+        p.coefficients.pop_back();
+    }
+}
+
+polynomial operator + (const polynomial& a,const polynomial& b) {
+    polynomial c;
+    c.coefficients.assign(std::max(a.coefficients.size(), b.coefficients.size()), 0);
+    for (int k = 0; k < a.coefficients.size(); k++) c.coefficients[k] = c.coefficients[k] + a.coefficients[k];
+    for (int k = 0; k < b.coefficients.size(); k++) c.coefficients[k] = c.coefficients[k] + b.coefficients[k];
+    trim(c);
+    return c;
+}
+
+polynomial operator - (const polynomial& a,const polynomial& b) {
+    polynomial c;
+    c.coefficients.assign(std::max(a.coefficients.size(), b.coefficients.size()), 0);
+    for (int k = 0; k < a.coefficients.size(); k++) c.coefficients[k] = c.coefficients[k] + a.coefficients[k];
+    for (int k = 0; k < b.coefficients.size(); k++) c.coefficients[k] = c.coefficients[k] - b.coefficients[k];
+    trim(c);
+    return c;
+}
+
+polynomial operator * (const polynomial& a,const polynomial& b) {
+    polynomial c;
+    c.coefficients.assign(a.coefficients.size() + b.coefficients.size() - 1, 0);
+    for (int i = 0; i < a.coefficients.size(); i++) {
+        for (int j = 0; j < b.coefficients.size(); j++) {
+            c.coefficients[i + j] = c.coefficients[i + j] + a.coefficients[i] * b.coefficients[j];
+        }
+    }
+    trim(c);
+    return c;
+}
+
+std::vector<complex> roots(polynomial p) {
+    trim(p);
+    int n = p.degree();
+    std::vector<complex> z;
+    if (n < 1) return z;
+
+    //start on a circle that contains every root (Cauchy bound), rotated so no guess is on an axis of symmetry
+    double bound = 0;
+    for (int k = 0; k < n; k++) {
+        bound = std::max(bound, (p.coefficients[k] / p.coefficients[n]).size());
+    }
+    bound += 1;
+    for (int i = 0; i < n; i++) {
+        double angle = (2 * 3.14159265359 * i) / n + 0.4;
+        z.push_back(complex(cos(angle), sin(angle)) * bound);
+    }
+
+    //Aberth iteration
+    for (int iteration = 0; iteration < 500; iteration++) {
+        bool done = true;
+        for (int i = 0; i < n; i++) {
+            complex value, derivative;
+            p.evaluate(z[i], value, derivative);
+            if (value == complex(0)) continue;
+            complex ratio = value / derivative;
+            complex sum = 0;
+            for (int j = 0; j < n; j++) {
+                if (j != i) sum = sum + 1 / (z[i] - z[j]);
+            }
+            complex correction = ratio / (1 - ratio * sum);
+            z[i] = z[i] - correction;
+            if (correction.size() > 1e-15 * (1 + z[i].size())) done = false;
+        }
+        if (done) break;
+    }
+    return z;
+}
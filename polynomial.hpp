@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "complex.hpp"
+
+/// @brief largest degree that is handled as a polynomial, anything bigger goes through the normal evaluator
+constexpr auto MAX_POLYNOMIAL_DEGREE = 64;
+
+/// @brief polynomial stored as coefficients, coefficients[k] multiplies x^k
+struct polynomial {
+    polynomial(complex constant = 0);
+    std::vector<complex> coefficients;
+
+    int degree();
+    complex evaluate(complex x);
+    void evaluate(complex x, complex& value, complex& derivative);
+};
+
+polynomial operator + (const polynomial& a,const polynomial& b);
+
+polynomial operator - (const polynomial& a,const polynomial& b);
+
+polynomial operator * (const polynomial& a,const polynomial& b);
+
+/// @brief find every root of a polynomial using the Aberth method
+std::vector<complex> roots(polynomial p);
@@ -0,0 +1,97 @@
+#include "roots.hpp"
+#include <cmath>
+
+//the spatial hash has at least twice as many slots as there can be roots, so a probe soon finds an empty one
+constexpr std::size_t SLOTS = 1 << 17;
+
+//cells are this many times the tolerance
+constexpr double CELLS_PER_TOLERANCE = 4;
+
+/// @brief negative zero is hard to remove in Ofast
+/// @param v pointer to double to use
+static void removeNegativeZero(double* v){
+    unsigned long long* g = (unsigned long long*)(v);
+    if(*g == 0x8000000000000000)
+        *g = 0;
+
+}
+
+/// @brief weird hash funtion that takes in a complex number
+/// @param input complex number
+/// @return integer
+static unsigned long long simpleHash(complex input){
+    removeNegativeZero(&input.re);
+    removeNegativeZero(&input.im);
+    unsigned long long output = 0;
+    //make a float pointer with the same adress as output
+    float* floatptr = (float*)(&output);
+    *floatptr = input.re + 0;
+    *(floatptr + 1) = input.im + 0;
+    return output;
+}
+
+rootRegistry::rootRegistry(double tolerance) : tolerance(tolerance), cellSize(tolerance * CELLS_PER_TOLERANCE), slots(SLOTS), roots(MAX_ROOTS) {}
+
+std::size_t rootRegistry::slot(long long cellRe, long long cellIm) const {
+    unsigned long long v = ((unsigned long long)cellRe * 0x9E3779B97F4A7C15) ^ ((unsigned long long)cellIm * 0xC2B2AE3D27D4EB4F);
+    return (v ^ (v >> 29)) & (SLOTS - 1);
+}
+
+/// @return ID of a root closer than the tolerance to value in the cells from first to last, or NO_ROOT
+uint16_t rootRegistry::lookup(const complex& value, long long firstRe, long long lastRe, long long firstIm, long long lastIm) const {
+    for (long long re = firstRe; re <= lastRe; re++) {
+        for (long long im = firstIm; im <= lastIm; im++) {
+            for (std::size_t i = slot(re, im); ; i = (i + 1) & (SLOTS - 1)) {
+                uint32_t id = slots[i].load(std::memory_order_acquire);
+                if (id == 0) break;
+                const rootEntry& entry = roots[id - 1];
+                if (entry.cellRe == re && entry.cellIm == im && std::hypot(entry.value.re - value.re, entry.value.im - value.im) < tolerance)
+                    return uint16_t(id - 1);
+            }
+        }
+    }
+    return NO_ROOT;
+}
+
+uint16_t rootRegistry::find(const complex& value, const std::function<complex(const complex&)>& polish) {
+    //past this the cells don't fit in a long long
+    const double largest = 1e18;
+    if (!std::isfinite(value.re) || !std::isfinite(value.im) || std::abs(value.re) / cellSize > largest || std::abs(value.im) / cellSize > largest)
+        return NO_ROOT;
+    //a root closer than the tolerance is in one of the cells that the square of the tolerance around value touches
+    long long firstRe = (long long)std::floor((value.re - tolerance) / cellSize);
+    long long lastRe = (long long)std::floor((value.re + tolerance) / cellSize);
+    long long firstIm = (long long)std::floor((value.im - tolerance) / cellSize);
+    long long lastIm = (long long)std::floor((value.im + tolerance) / cellSize);
+    uint16_t id = lookup(value, firstRe, lastRe, firstIm, lastIm);
+    if (id != NO_ROOT)
+        return id;
+
+    std::lock_guard<std::mutex> guard(adding);
+    //another worker could have added it since
+    id = lookup(value, firstRe, lastRe, firstIm, lastIm);
+    if (id != NO_ROOT)
+        return id;
+    int next = count.load(std::memory_order_relaxed);
+    if (next >= MAX_ROOTS)
+        return NO_ROOT;
+    //a polish that fails or goes off to another root leaves the first result
+    complex root = value;
+    if (polish) {
+        complex polished = polish(value);
+        if (std::isfinite(polished.re) && std::isfinite(polished.im) && std::hypot(polished.re - value.re, polished.im - value.im) < tolerance)
+            root = polished;
+    }
+    rootEntry& entry = roots[next];
+    entry.value = root;
+    entry.cellRe = (long long)std::floor(root.re / cellSize);
+    entry.cellIm = (long long)std::floor(root.im / cellSize);
+    //the color comes from the grid point the polished root is nearest, so it is the same in every render
+    entry.hash = simpleHash(complex(std::round(root.re / tolerance) * tolerance, std::round(root.im / tolerance) * tolerance));
+    std::size_t i = slot(entry.cellRe, entry.cellIm);
+    while (slots[i].load(std::memory_order_relaxed) != 0)
+        i = (i + 1) & (SLOTS - 1);
+    slots[i].store(uint32_t(next + 1), std::memory_order_release);
+    count.store(next + 1, std::memory_order_release);
+    return uint16_t(next);
+}
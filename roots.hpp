@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "complex.hpp"
+
+/// @brief ID of the root in a pixelResult when the pixel didn't converge
+constexpr uint16_t NO_ROOT = 0xFFFF;
+
+/// @brief what one sample of one pixel found. Roots are kept as an ID from a rootRegistry so a whole image of
+/// these is 4 bytes a pixel
+struct pixelResult {
+    //ID from the rootRegistry, or NO_ROOT
+    uint16_t root;
+    //steps it took to converge, or for NO_ROOT the length of the cycle the pixel was stuck in, 0 if it wasn't in one
+    uint16_t steps;
+};
+
+/// @brief gives every root found a small ID, a result closer than tolerance to a root that was already found gets
+/// its ID. Can be used from every worker at once, finding a root that is already there doesn't take a lock
+class rootRegistry {
+public:
+    /// @brief the largest number of roots, results past that are given NO_ROOT
+    static constexpr int MAX_ROOTS = NO_ROOT;
+
+    explicit rootRegistry(double tolerance);
+
+    /// @return ID of the root value is at, the first time a root is seen it is added
+    /// @param polish takes the first result of a new root the rest of the way to it, so the root kept for the ID and
+    /// its color don't depend on which worker happened to find it first
+    uint16_t find(const complex& value, const std::function<complex(const complex&)>& polish = nullptr);
+
+    /// @return the root with the ID, polished if find was given a polish, otherwise the first result that was given
+    /// the ID. Only for IDs this thread got from find, or after the render that found them has finished
+    const complex& root(uint16_t id) const {
+        return roots[id].value;
+    }
+
+    /// @return a hash of where the root is, snapped to a grid the size of the tolerance, to pick its color by
+    unsigned long long hash(uint16_t id) const {
+        return roots[id].hash;
+    }
+
+    /// @return number of roots added so far
+    int size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+private:
+    struct rootEntry {
+        complex value;
+        //cell of the spatial hash the root is in
+        long long cellRe;
+        long long cellIm;
+        unsigned long long hash;
+    };
+
+    uint16_t lookup(const complex& value, long long firstRe, long long lastRe, long long firstIm, long long lastIm) const;
+    std::size_t slot(long long cellRe, long long cellIm) const;
+
+    double tolerance;
+    //side of the cells of the spatial hash, a few times the tolerance so most results only look in one or two
+    double cellSize;
+    //the spatial hash, open addressing with the ID + 1 of a root in each slot and 0 in empty ones. Slots are only
+    //ever filled in, after the root they point to is written, so they can be read without a lock
+    std::vector<std::atomic<uint32_t>> slots;
+    //sized for every ID up front so it never moves while another thread reads it
+    std::vector<rootEntry> roots;
+    std::atomic<int> count{ 0 };
+    //held while a root is added, so two workers finding the same new root give it one ID
+    std::mutex adding;
+};
@@ -0,0 +1,177 @@
+#include "scheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#ifdef _WIN32
+//windows.h defines min and max as macros, which would break std::min and std::max
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// @brief a cpu the process may run on and how fast it is compared to the others
+struct cpuInfo {
+    int id;
+    double speed;
+};
+
+#ifdef __linux__
+//reads one number from a file in /sys, or 0 if there isn't one
+static double readNumber(const std::string& path) {
+    std::ifstream file(path);
+    double value = 0;
+    file >> value;
+    return file ? value : 0;
+}
+#endif
+
+/// @return the cpus this process is allowed on, fastest first. Speed is the capacity the kernel gives each cpu on
+/// hybrid arm chips, or the highest clock otherwise, which is what tells the P and E cores of intel chips apart
+static std::vector<cpuInfo> usableCpus() {
+    std::vector<cpuInfo> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (!CPU_ISSET(i, &set)) continue;
+            std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(i);
+            double speed = readNumber(base + "/cpu_capacity");
+            if (speed == 0) speed = readNumber(base + "/cpufreq/cpuinfo_max_freq");
+            cpus.push_back({ i, speed });
+        }
+    }
+#elif defined(_WIN32)
+    for (int i = 0; i < int(std::min(std::thread::hardware_concurrency(), 64u)); i++)
+        cpus.push_back({ i, 0 });
+#endif
+    //a cpu that didn't say how fast it is counts as the same as the fastest
+    double fastest = 0;
+    for (const cpuInfo& cpu : cpus)
+        fastest = std::max(fastest, cpu.speed);
+    for (cpuInfo& cpu : cpus)
+        cpu.speed = cpu.speed > 0 ? cpu.speed / fastest : 1;
+    std::stable_sort(cpus.begin(), cpus.end(), [](const cpuInfo& a, const cpuInfo& b) { return a.speed > b.speed; });
+    return cpus;
+}
+
+/// @return weather the thread could be moved to the cpu
+static bool pinThread(std::thread& thread, int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu) != 0;
+#else
+    return false;
+#endif
+}
+
+workerPool::workerPool(unsigned int workers, bool pinned) : queues(workers > 0 ? workers : 1), speed(queues.size(), 1) {
+    std::vector<cpuInfo> cpus;
+    if (pinned) cpus = usableCpus();
+    for (unsigned int i = 0; i < queues.size(); i++) {
+        threads.emplace_back(&workerPool::workerLoop, this, i);
+        //more workers than cpus share them from the fastest one again
+        if (cpus.size() > 0 && pinThread(threads[i], cpus[i % cpus.size()].id))
+            speed[i] = cpus[i % cpus.size()].speed;
+    }
+}
+
+workerPool::~workerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    started.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void workerPool::run(int tasks, const std::function<void(unsigned int, int)>& work, const std::function<void()>& waiting) {
+    if (tasks <= 0) return;
+    std::unique_lock<std::mutex> guard(lock);
+    //neighbouring tasks are neighbouring parts of the image, so each worker gets one block of them to start with,
+    //as big as its share of the total speed. The same tasks always start on the same worker, so a job can touch
+    //memory first on the worker that will use it in the next job
+    double totalSpeed = 0;
+    for (double s : speed)
+        totalSpeed += s;
+    double before = 0;
+    for (unsigned int i = 0; i < queues.size(); i++) {
+        std::lock_guard<std::mutex> queueGuard(queues[i].lock);
+        queues[i].tasks.clear();
+        int first = int(tasks * (before / totalSpeed) + 0.5);
+        before += speed[i];
+        int last = i == queues.size() - 1 ? tasks : int(tasks * (before / totalSpeed) + 0.5);
+        for (int task = first; task < last; task++)
+            queues[i].tasks.push_back(task);
+    }
+    job = &work;
+    total = tasks;
+    done = 0;
+    generation++;
+    started.notify_all();
+
+    //a worker that is still looking for tasks could take one from the next job, so wait for all of them to stop too
+    while (!finishedAll.wait_for(guard, std::chrono::milliseconds(100), [&] { return done == total && busy == 0; })) {
+        if (waiting) {
+            guard.unlock();
+            waiting();
+            guard.lock();
+        }
+    }
+    job = nullptr;
+}
+
+bool workerPool::take(unsigned int worker, int& task) {
+    {
+        taskQueue& own = queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (unsigned int i = 1; i < queues.size(); i++) {
+        taskQueue& victim = queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void workerPool::workerLoop(unsigned int worker) {
+    unsigned long long seen = 0;
+    while (true) {
+        const std::function<void(unsigned int, int)>* work;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            started.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            work = job;
+            busy++;
+        }
+        int task;
+        while (work != nullptr && take(worker, task)) {
+            (*work)(worker, task);
+            done++;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            busy--;
+        }
+        finishedAll.notify_all();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief threads that are started once and kept for every job after. A job is a number of tasks that are
+/// split between the workers in contiguous blocks, each worker does its own block in order and when it runs
+/// out steals from the far end of another worker's block, so one slow part of the image doesn't hold up the rest
+class workerPool {
+public:
+    /// @param pinned keep each worker on one cpu, fastest cpus first. The blocks a job starts with are then sized by
+    /// the speed of each cpu so the slower cores of a hybrid cpu get less to start with, and memory a worker
+    /// touches first stays on its NUMA node
+    explicit workerPool(unsigned int workers, bool pinned = false);
+    ~workerPool();
+
+    workerPool(const workerPool&) = delete;
+    workerPool& operator = (const workerPool&) = delete;
+
+    unsigned int size() const {
+        return unsigned(queues.size());
+    }
+
+    /// @brief run work(worker, task) for every task from 0 to tasks - 1 and wait for them to finish
+    /// @param work called on the worker threads, worker is from 0 to size() - 1 so each can keep its own state
+    /// @param waiting called on the calling thread about every 100ms until the job is done, to show progress
+    void run(int tasks, const std::function<void(unsigned int worker, int task)>& work, const std::function<void()>& waiting = nullptr);
+
+    /// @brief number of tasks of the current job that are finished
+    int finished() const {
+        return done.load(std::memory_order_relaxed);
+    }
+
+private:
+    //tasks of one worker, the owner takes from the front and thieves from the back
+    struct taskQueue {
+        std::mutex lock;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(unsigned int worker);
+    bool take(unsigned int worker, int& task);
+
+    std::vector<std::thread> threads;
+    std::vector<taskQueue> queues;
+    //relative speed of the cpu each worker is on, all 1 unless pinned
+    std::vector<double> speed;
+
+    std::mutex lock;
+    std::condition_variable started;
+    std::condition_variable finishedAll;
+    //bumped for every job so a worker knows there is new work
+    unsigned long long generation = 0;
+    bool stopping = false;
+    const std::function<void(unsigned int, int)>* job = nullptr;
+    int total = 0;
+    //workers that are working on or looking for tasks of the current job
+    int busy = 0;
+    std::atomic<int> done{ 0 };
+};
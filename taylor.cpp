@@ -0,0 +1,238 @@
+#include "taylor.hpp"
+#include "extended.hpp"
+
+//math on the parts is unqualified so the double-double and quad-double versions are found too
+using std::sqrt;
+using std::atan2;
+using std::sin;
+using std::cos;
+using std::sinh;
+using std::cosh;
+using std::log;
+using std::exp;
+
+//Each function works out the terms in order from the recurrence for its taylor series, every
+//step of which is a loop over the lanes like in batch.cpp. out is never one of the inputs
+
+/// @brief out = a * b for every lane
+template<typename T>
+static void multiply(basicComplexBatch<T>& out, const basicComplexBatch<T>& a, const basicComplexBatch<T>& b) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T re = (a.re[i] * b.re[i]) - (a.im[i] * b.im[i]);
+        T im = (a.im[i] * b.re[i]) + (a.re[i] * b.im[i]);
+        out.re[i] = re;
+        out.im[i] = im;
+    }
+}
+
+/// @brief out += a * b * scale for every lane
+template<typename T>
+static void multiplyAdd(basicComplexBatch<T>& out, const basicComplexBatch<T>& a, const basicComplexBatch<T>& b, T scale) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        out.re[i] += ((a.re[i] * b.re[i]) - (a.im[i] * b.im[i])) * scale;
+        out.im[i] += ((a.im[i] * b.re[i]) + (a.re[i] * b.im[i])) * scale;
+    }
+}
+
+/// @brief out = 1 / a for every lane
+template<typename T>
+static void reciprocal(basicComplexBatch<T>& out, const basicComplexBatch<T>& a) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        T c = 1 / ((a.re[i] * a.re[i]) + (a.im[i] * a.im[i]));
+        out.re[i] = a.re[i] * c;
+        out.im[i] = -a.im[i] * c;
+    }
+}
+
+template<typename T>
+static void fill(basicComplexBatch<T>& out, T re, T im) {
+    for (int i = 0; i < batchSize<T>; i++) {
+        out.re[i] = re;
+        out.im[i] = im;
+    }
+}
+
+template<typename T>
+void broadcast(basicTaylorBatch<T>& out, double re, double im, double derivativeRe, double derivativeIm, int terms) {
+    fill(out.term[0], T(re), T(im));
+    if (terms > 1) fill(out.term[1], T(derivativeRe), T(derivativeIm));
+    for (int k = 2; k < terms; k++)
+        fill(out.term[k], T(0), T(0));
+}
+
+template<typename T>
+void add(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms) {
+    for (int k = 0; k < terms; k++) {
+        for (int i = 0; i < batchSize<T>; i++) {
+            out.term[k].re[i] = a.term[k].re[i] + b.term[k].re[i];
+            out.term[k].im[i] = a.term[k].im[i] + b.term[k].im[i];
+        }
+    }
+}
+
+template<typename T>
+void subtract(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms) {
+    for (int k = 0; k < terms; k++) {
+        for (int i = 0; i < batchSize<T>; i++) {
+            out.term[k].re[i] = a.term[k].re[i] - b.term[k].re[i];
+            out.term[k].im[i] = a.term[k].im[i] - b.term[k].im[i];
+        }
+    }
+}
+
+//(ab)_k = sum of a_j*b_(k-j)
+template<typename T>
+void multiply(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms) {
+    for (int k = 0; k < terms; k++) {
+        multiply(out.term[k], a.term[0], b.term[k]);
+        for (int j = 1; j <= k; j++)
+            multiplyAdd(out.term[k], a.term[j], b.term[k - j], T(1));
+    }
+}
+
+//from a = (a/b)*b, (a/b)_k = (a_k - sum of b_j*(a/b)_(k-j) for j > 0)/b_0
+template<typename T>
+void divide(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms) {
+    basicComplexBatch<T> inverse, sum;
+    reciprocal(inverse, b.term[0]);
+    for (int k = 0; k < terms; k++) {
+        sum = a.term[k];
+        for (int j = 1; j <= k; j++)
+            multiplyAdd(sum, b.term[j], out.term[k - j], T(-1));
+        multiply(out.term[k], sum, inverse);
+    }
+}
+
+template<typename T>
+void reciprocal(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, int terms) {
+    basicComplexBatch<T> inverse, sum;
+    reciprocal(inverse, a.term[0]);
+    out.term[0] = inverse;
+    for (int k = 1; k < terms; k++) {
+        fill(sum, T(0), T(0));
+        for (int j = 1; j <= k; j++)
+            multiplyAdd(sum, a.term[j], out.term[k - j], T(-1));
+        multiply(out.term[k], sum, inverse);
+    }
+}
+
+template<typename T>
+void square(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, int terms) {
+    multiply(out, a, a, terms);
+}
+
+//from s' = c*x' and c' = -s*x', s_k = sum of (j/k)*x_j*c_(k-j) and c_k = -sum of (j/k)*x_j*s_(k-j)
+template<typename T>
+void sincos(basicTaylorBatch<T>& s, basicTaylorBatch<T>& c, const basicTaylorBatch<T>& x, int terms) {
+    //sin and cos go in separate loops, otherwise the compiler merges them into a sincos call that it can't vectorize
+    T sinre[batchSize<T>], cosre[batchSize<T>];
+    for (int i = 0; i < batchSize<T>; i++)
+        sinre[i] = sin(x.term[0].re[i]);
+    for (int i = 0; i < batchSize<T>; i++)
+        cosre[i] = cos(x.term[0].re[i]);
+    for (int i = 0; i < batchSize<T>; i++) {
+        T coshim = cosh(x.term[0].im[i]);
+        T sinhim = sinh(x.term[0].im[i]);
+        s.term[0].re[i] = sinre[i] * coshim;
+        s.term[0].im[i] = cosre[i] * sinhim;
+        c.term[0].re[i] = cosre[i] * coshim;
+        c.term[0].im[i] = -sinre[i] * sinhim;
+    }
+    for (int k = 1; k < terms; k++) {
+        fill(s.term[k], T(0), T(0));
+        fill(c.term[k], T(0), T(0));
+        for (int j = 1; j <= k; j++) {
+            multiplyAdd(s.term[k], x.term[j], c.term[k - j], T(j) / T(k));
+            multiplyAdd(c.term[k], x.term[j], s.term[k - j], -T(j) / T(k));
+        }
+    }
+}
+
+//from x = exp(l), x_k = sum of (j/k)*l_j*x_(k-j), so l_k = (x_k - sum of (j/k)*l_j*x_(k-j) for j < k)/x_0
+template<typename T>
+void log(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& x, int terms) {
+    basicComplexBatch<T> inverse, sum;
+    reciprocal(inverse, x.term[0]);
+    for (int i = 0; i < batchSize<T>; i++) {
+        T re = x.term[0].re[i], im = x.term[0].im[i];
+        out.term[0].re[i] = log(sqrt((re * re) + (im * im)));
+        out.term[0].im[i] = atan2(im, re);
+    }
+    for (int k = 1; k < terms; k++) {
+        sum = x.term[k];
+        for (int j = 1; j < k; j++)
+            multiplyAdd(sum, out.term[j], x.term[k - j], -T(j) / T(k));
+        multiply(out.term[k], sum, inverse);
+    }
+}
+
+//from e' = e*x', e_k = sum of (j/k)*x_j*e_(k-j)
+template<typename T>
+void exp(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& x, int terms) {
+    //separate loops for the same reason as sincos
+    T cosim[batchSize<T>], sinim[batchSize<T>];
+    for (int i = 0; i < batchSize<T>; i++)
+        cosim[i] = cos(x.term[0].im[i]);
+    for (int i = 0; i < batchSize<T>; i++)
+        sinim[i] = sin(x.term[0].im[i]);
+    for (int i = 0; i < batchSize<T>; i++) {
+        T e = exp(x.term[0].re[i]);
+        out.term[0].re[i] = e * cosim[i];
+        out.term[0].im[i] = e * sinim[i];
+    }
+    for (int k = 1; k < terms; k++) {
+        fill(out.term[k], T(0), T(0));
+        for (int j = 1; j <= k; j++)
+            multiplyAdd(out.term[k], x.term[j], out.term[k - j], T(j) / T(k));
+    }
+}
+
+//repeated squaring, n is at least 1
+template<typename T>
+void powi(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& x, int n, int terms) {
+    basicTaylorBatch<T> base = x, temp;
+    bool first = true;
+    while (n > 0) {
+        if (n & 1) {
+            if (first) out = base;
+            else {
+                multiply(temp, out, base, terms);
+                out = temp;
+            }
+            first = false;
+        }
+        n >>= 1;
+        if (n > 0) {
+            square(temp, base, terms);
+            base = temp;
+        }
+    }
+}
+
+//a^b = exp(b*ln(a))
+template<typename T>
+void pow(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms) {
+    basicTaylorBatch<T> l, m;
+    log(l, a, terms);
+    multiply(m, b, l, terms);
+    exp(out, m, terms);
+}
+
+#define INSTANTIATE_TAYLOR(T) \
+    template void broadcast(basicTaylorBatch<T>&, double, double, double, double, int); \
+    template void add(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void subtract(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void multiply(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void divide(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void reciprocal(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void square(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void sincos(basicTaylorBatch<T>&, basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void log(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void exp(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int); \
+    template void powi(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int, int); \
+    template void pow(basicTaylorBatch<T>&, const basicTaylorBatch<T>&, const basicTaylorBatch<T>&, int);
+
+INSTANTIATE_TAYLOR(float)
+INSTANTIATE_TAYLOR(double)
+INSTANTIATE_TAYLOR(doubleDouble)
+INSTANTIATE_TAYLOR(quadDouble)
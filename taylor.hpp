@@ -0,0 +1,49 @@
+#pragma once
+#include "batch.hpp"
+
+/// @brief most terms a taylor batch can hold, enough for householder methods up to order MAX_TAYLOR_TERMS - 1
+constexpr int MAX_TAYLOR_TERMS = 5;
+
+/// @brief batch version of the first terms of a taylor series, term[k] is the k-th derivative / k! for each lane.
+/// basicDualBatch is the same thing with two terms, this is for the methods that need higher derivatives.
+/// Every function takes the number of terms to work out so lower orders don't pay for the unused ones
+template<typename T>
+struct basicTaylorBatch {
+    basicComplexBatch<T> term[MAX_TAYLOR_TERMS];
+};
+
+template<typename T>
+void broadcast(basicTaylorBatch<T>& out, double re, double im, double derivativeRe, double derivativeIm, int terms);
+
+template<typename T>
+void add(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms);
+
+template<typename T>
+void subtract(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms);
+
+template<typename T>
+void multiply(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms);
+
+template<typename T>
+void divide(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms);
+
+template<typename T>
+void reciprocal(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, int terms);
+
+template<typename T>
+void square(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, int terms);
+
+template<typename T>
+void sincos(basicTaylorBatch<T>& s, basicTaylorBatch<T>& c, const basicTaylorBatch<T>& x, int terms);
+
+template<typename T>
+void log(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& x, int terms);
+
+template<typename T>
+void exp(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& x, int terms);
+
+template<typename T>
+void powi(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& x, int n, int terms);
+
+template<typename T>
+void pow(basicTaylorBatch<T>& out, const basicTaylorBatch<T>& a, const basicTaylorBatch<T>& b, int terms);